@@ -0,0 +1,165 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "../include/shader.hpp"
+#include "../include/profiler.hpp"
+#include "../include/texture.hpp"
+#include "../include/cube.hpp"
+#include "../include/mesh.hpp"
+#include "../include/chunk.hpp"
+#include "../include/light.hpp"
+#include "../include/chunk_mesh.hpp"
+#include "../include/frustum.hpp"
+#include "../include/headless.hpp"
+#include "./microbench.hpp"
+
+// Micro-benchmarks for the hot paths, on a headless GL context.
+// meson test --benchmark runs them all; run the binary directly to pick some:
+//   micro-benchmarks [--filter <substring>] [--assets <dir>] [--repetitions N] [--warmup N]
+
+int main(int argc, char** argv) {
+    std::string filter;
+    std::string assets = "../Assets";
+    MicroBenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--assets" && i + 1 < argc)
+            assets = argv[++i];
+        else if (arg == "--repetitions" && i + 1 < argc)
+            options.repetitions = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && i + 1 < argc)
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+    }
+
+    // Loading and uniform updates need a context; the numbers are CPU time either way
+    headlessPlatformHint();
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = createHeadlessWindow(64, 64, "Micro-benchmarks");
+    if (!window) {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (headlessGlewInit() != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        return 1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    int failed = 0;
+    bool headerPrinted = false;
+    auto run = [&](const std::string &name, const MicroBenchmarkOptions &runOptions, const std::function<void()> &fn) {
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+            return;
+        if (!headerPrinted) {
+            printMicroBenchmarkHeader();
+            headerPrinted = true;
+        }
+        printMicroBenchmarkResult(runMicroBenchmark(name, fn, runOptions));
+    };
+
+    // Asset loading: one call per repetition, it is slow enough to time on its own
+    MicroBenchmarkOptions loadOptions = options;
+    loadOptions.warmup = std::min(options.warmup, 1);
+    loadOptions.minBatchSeconds = 0.0;
+    std::string modelPath = assets + "/rigged_human.obj";
+    std::string texturePath = assets + "/skin_texture.jpg";
+    run("loadModel rigged_human.obj", loadOptions, [&] {
+        Mesh mesh = loadModel(modelPath);
+        if (mesh.vertices.empty())
+            failed++;
+        glDeleteVertexArrays(1, &mesh.VAO);
+        glDeleteBuffers(1, &mesh.VBO);
+        glDeleteBuffers(1, &mesh.EBO);
+    });
+    run("decodeImage skin_texture.jpg", loadOptions, [&] {
+        DecodedImage image = decodeImage(texturePath.c_str());
+        if (!image.data)
+            failed++;
+        stbi_image_free(image.data);
+    });
+
+    // Per-object math the render thread does every frame
+    Cube cube(glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(45.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f), 1, true, 12.0f);
+    cube.updateRotation(1.0f / 60.0f);
+    float alpha = 0.0f;
+    run("Cube model matrix", options, [&] {
+        alpha = alpha < 1.0f ? alpha + 0.001f : 0.0f;
+        glm::mat4 model = cube.modelMatrix(alpha);
+        doNotOptimize(model);
+    });
+
+    // The game's start camera against a 32x4x32 chunk grid; most of it is past the far plane
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 9.84f, 14.36f), glm::vec3(0.0f, 9.36f, 13.48f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    std::vector<glm::vec3> chunkOrigins;
+    for (int z = 0; z < 32; z++)
+        for (int y = 0; y < 4; y++)
+            for (int x = 0; x < 32; x++)
+                chunkOrigins.push_back(glm::vec3(-256.0f + x * CHUNK_SIZE, -32.0f + y * CHUNK_SIZE, -256.0f + z * CHUNK_SIZE));
+    run("Frustum cull 4096 chunks", options, [&] {
+        Frustum frustum(projection * view);
+        int visible = 0;
+        for (const glm::vec3 &origin : chunkOrigins)
+            visible += frustum.intersectsBox(origin, origin + glm::vec3((float)CHUNK_SIZE));
+        doNotOptimize(visible);
+    });
+
+    // Meshing the game's terrain one chunk at a time, buffers reused as WorldRenderer does
+    World world(glm::ivec3(4, 2, 4), glm::ivec3(-32, -17, -70));
+    generateTerrain(world);
+    LightEngine lightEngine(world);
+    lightEngine.lightWorld();
+    std::vector<ChunkVertex> vertices;
+    std::vector<GLushort> indices;
+    size_t chunk = 0;
+    run("buildChunkMesh", options, [&] {
+        buildChunkMesh(world, world.chunks[chunk], vertices, indices);
+        chunk = (chunk + 1) % world.chunks.size();
+        doNotOptimize(indices.data());
+    });
+
+    // Uniform updates through Shader, which looks the location up by name every call
+    Shader shader(vertexShaderSource, fragmentShaderSource);
+    shader.use();
+    glm::mat4 model = cube.modelMatrix();
+    run("Shader::setMat4", options, [&] {
+        shader.setMat4("model", model);
+    });
+    run("Shader::setFloat", options, [&] {
+        shader.setFloat("timeOfDay", 0.5f);
+    });
+    glFinish();
+
+    glDeleteProgram(shader.ID);
+    glDeleteVertexArrays(1, &cube.VAO);
+    glDeleteBuffers(1, &cube.VBO);
+    glfwTerminate();
+    if (failed > 0) {
+        std::cerr << "ERROR::BENCHMARK::ASSETS_NOT_FOUND in " << assets << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#ifndef MICROBENCH_HPP_
+#define MICROBENCH_HPP_
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Minimal micro-benchmark harness. A benchmark is a callable run in batches:
+//  - calibration doubles the batch until it takes at least minBatchSeconds, so timer
+//    resolution and loop overhead stay negligible
+//  - warmup batches run first and are thrown away (caches, lazy driver state)
+//  - each repetition times one batch; mean, standard deviation, min and median are
+//    per iteration over the repetitions
+// A coefficient of variation (stddev / mean) above a few percent means the machine
+// was busy; compare optimizations on min or median, with the CV in view.
+
+struct MicroBenchmarkOptions {
+    int warmup = 3;
+    int repetitions = 15;
+    double minBatchSeconds = 0.05;
+    long long maxIterations = 1LL << 30;
+};
+
+struct MicroBenchmarkResult {
+    std::string name;
+    long long iterations; // per repetition
+    std::vector<double> samples; // ns per iteration, one per repetition
+    double mean, stddev, min, median;
+};
+
+// Keeps a result alive so the optimizer cannot drop the work producing it
+template <typename T>
+inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+template <typename Fn>
+MicroBenchmarkResult runMicroBenchmark(const std::string &name, Fn &&fn, const MicroBenchmarkOptions &options = MicroBenchmarkOptions()) {
+    typedef std::chrono::steady_clock Clock;
+    auto batch = [&](long long iterations) {
+        Clock::time_point start = Clock::now();
+        for (long long i = 0; i < iterations; i++)
+            fn();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    MicroBenchmarkResult result;
+    result.name = name;
+    result.iterations = 1;
+    while (batch(result.iterations) < options.minBatchSeconds && result.iterations < options.maxIterations)
+        result.iterations *= 2;
+    for (int i = 0; i < options.warmup; i++)
+        batch(result.iterations);
+    for (int i = 0; i < options.repetitions; i++)
+        result.samples.push_back(batch(result.iterations) * 1.0e9 / result.iterations);
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double ns : sorted)
+        sum += ns;
+    result.mean = sum / sorted.size();
+    double variance = 0.0;
+    for (double ns : sorted)
+        variance += (ns - result.mean) * (ns - result.mean);
+    result.stddev = sorted.size() > 1 ? std::sqrt(variance / (sorted.size() - 1)) : 0.0;
+    result.min = sorted.front();
+    result.median = sorted.size() % 2 ? sorted[sorted.size() / 2] : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) * 0.5;
+    return result;
+}
+
+// Picks ns, us or ms so the numbers stay readable
+inline std::string formatDuration(double ns) {
+    char buffer[32];
+    if (ns < 1.0e3)
+        std::snprintf(buffer, sizeof(buffer), "%.2f ns", ns);
+    else if (ns < 1.0e6)
+        std::snprintf(buffer, sizeof(buffer), "%.2f us", ns / 1.0e3);
+    else
+        std::snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1.0e6);
+    return buffer;
+}
+
+inline void printMicroBenchmarkHeader() {
+    std::printf("%-36s %12s %12s %7s %12s %12s %14s\n", "benchmark", "mean", "stddev", "cv", "min", "median", "iterations");
+}
+
+inline void printMicroBenchmarkResult(const MicroBenchmarkResult &result) {
+    std::printf("%-36s %12s %12s %6.2f%% %12s %12s %8lld x %-3d\n", result.name.c_str(),
+                formatDuration(result.mean).c_str(), formatDuration(result.stddev).c_str(),
+                result.mean > 0.0 ? result.stddev / result.mean * 100.0 : 0.0,
+                formatDuration(result.min).c_str(), formatDuration(result.median).c_str(),
+                result.iterations, (int)result.samples.size());
+    std::fflush(stdout);
+}
+
+#endif // MICROBENCH_HPP_
@@ -0,0 +1,249 @@
+#ifndef ANIM_COMPRESS_HPP_
+#define ANIM_COMPRESS_HPP_
+#include "./animation.hpp"
+#include <cstring>
+
+// Compressed animation clips.
+//  - every channel is resampled at a fixed rate, then keys that linear interpolation
+//    reproduces within a tolerance are dropped
+//  - rotations use smallest-three quantization, 48 bits per key
+//  - translations and scales are quantized to 16 bits per component over the track's range
+//  - all tracks live in one blob in joint order (T, R, S per joint), so a forward
+//    playback walks the memory front to back; per-layer cursors make key lookup O(1)
+
+struct ClipCompressionSettings {
+    float sampleRate = 30.0f;
+    float translationTolerance = 0.001f; // model units
+    float rotationTolerance = 0.0005f;   // per quaternion component
+    float scaleTolerance = 0.0005f;
+};
+
+enum ClipChannel : uint8_t { CHANNEL_TRANSLATION, CHANNEL_ROTATION, CHANNEL_SCALE };
+
+struct CompressedTrack {
+    uint32_t offset;   // into CompressedClip::data
+    uint16_t keyCount;
+    uint16_t joint;
+    ClipChannel channel;
+};
+
+// Last decoded key per track; lets forward playback skip the key search
+struct ClipCursor {
+    std::vector<uint16_t> keys;
+};
+
+struct CompressedClip {
+    std::string name;
+    float duration;
+    float sampleRate;
+    int jointCount;
+    std::vector<CompressedTrack> tracks;
+    std::vector<uint8_t> data;
+
+    size_t sizeBytes() const {
+        return sizeof(CompressedClip) + tracks.size() * sizeof(CompressedTrack) + data.size();
+    }
+};
+
+// Memory taken by the imported float keys, for comparison
+inline size_t rawClipBytes(const AnimationClip &clip) {
+    size_t bytes = sizeof(AnimationClip) + clip.tracks.size() * sizeof(JointTrack);
+    for (const JointTrack &track : clip.tracks)
+        bytes += (track.positions.size() + track.scales.size()) * sizeof(Keyframe<glm::vec3>) +
+                 track.rotations.size() * sizeof(Keyframe<glm::quat>);
+    return bytes;
+}
+
+const float SMALLEST_THREE_RANGE = 0.70710678f; // 1/sqrt(2), bound of the three smallest components
+
+inline void packQuaternion(const float q[4], uint16_t out[3]) {
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+        if (fabs(q[i]) > fabs(q[largest]))
+            largest = i;
+    float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    uint64_t bits = (uint64_t)largest;
+    int shift = 2;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float v = glm::clamp(q[i] * sign / SMALLEST_THREE_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+        bits |= (uint64_t)(v * 32767.0f + 0.5f) << shift;
+        shift += 15;
+    }
+    out[0] = (uint16_t)bits;
+    out[1] = (uint16_t)(bits >> 16);
+    out[2] = (uint16_t)(bits >> 32);
+}
+
+inline void unpackQuaternion(const uint16_t in[3], float q[4]) {
+    uint64_t bits = (uint64_t)in[0] | ((uint64_t)in[1] << 16) | ((uint64_t)in[2] << 32);
+    int largest = (int)(bits & 3);
+    int shift = 2;
+    float sumSq = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        if (i == largest)
+            continue;
+        float v = (float)((bits >> shift) & 0x7FFF) / 32767.0f;
+        q[i] = (v * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+        sumSq += q[i] * q[i];
+        shift += 15;
+    }
+    q[largest] = sqrt(std::max(0.0f, 1.0f - sumSq));
+}
+
+// Greedy key reduction over uniformly sampled values (`width` floats per frame):
+// extends each segment while linear interpolation stays within tolerance.
+inline std::vector<int> reduceKeys(const std::vector<float> &values, int width, float tolerance) {
+    int frames = (int)values.size() / width;
+    std::vector<int> keys(1, 0);
+    int start = 0;
+    for (int end = 2; end < frames; end++) {
+        bool fits = true;
+        for (int f = start + 1; f < end && fits; f++) {
+            float t = (float)(f - start) / (float)(end - start);
+            for (int c = 0; c < width; c++) {
+                float a = values[start * width + c], b = values[end * width + c];
+                if (fabs(a + (b - a) * t - values[f * width + c]) > tolerance) {
+                    fits = false;
+                    break;
+                }
+            }
+        }
+        if (!fits) {
+            start = end - 1;
+            keys.push_back(start);
+        }
+    }
+    if (frames > 1)
+        keys.push_back(frames - 1);
+    // Constant tracks collapse to a single key
+    if (keys.size() == 2) {
+        bool constant = true;
+        for (int f = 1; f < frames && constant; f++)
+            for (int c = 0; c < width; c++)
+                if (fabs(values[f * width + c] - values[c]) > tolerance)
+                    constant = false;
+        if (constant)
+            keys.resize(1);
+    }
+    return keys;
+}
+
+template <typename T>
+void appendBytes(std::vector<uint8_t> &data, const T* values, size_t count) {
+    size_t at = data.size();
+    data.resize(at + count * sizeof(T));
+    memcpy(&data[at], values, count * sizeof(T));
+}
+
+CompressedClip compressClip(const Skeleton &skeleton, const AnimationClip &clip, const ClipCompressionSettings &settings = ClipCompressionSettings()) {
+    // Uniform resample first, reusing the SoA sampler's bind-pose fallback and hemisphere fix
+    SampledClip sampled = SampledClip::fromClip(skeleton, clip, settings.sampleRate);
+
+    CompressedClip out;
+    out.name = clip.name;
+    out.duration = clip.duration;
+    out.sampleRate = settings.sampleRate;
+    out.jointCount = (int)skeleton.joints.size();
+
+    const int firstStream[3] = { POSE_TX, POSE_RX, POSE_SX };
+    const int width[3] = { 3, 4, 3 };
+    const float tolerance[3] = { settings.translationTolerance, settings.rotationTolerance, settings.scaleTolerance };
+
+    std::vector<float> values;
+    for (int j = 0; j < out.jointCount; j++) {
+        for (int channel = 0; channel < 3; channel++) {
+            int w = width[channel];
+            values.resize((size_t)sampled.frameCount * w);
+            for (int f = 0; f < sampled.frameCount; f++)
+                for (int c = 0; c < w; c++)
+                    values[f * w + c] = sampled.stream(f, firstStream[channel] + c)[j];
+            std::vector<int> keys = reduceKeys(values, w, tolerance[channel]);
+
+            CompressedTrack track;
+            track.offset = (uint32_t)out.data.size();
+            track.keyCount = (uint16_t)keys.size();
+            track.joint = (uint16_t)j;
+            track.channel = (ClipChannel)channel;
+
+            std::vector<uint16_t> packed(keys.size() * 3);
+            if (channel == CHANNEL_ROTATION) {
+                for (size_t k = 0; k < keys.size(); k++)
+                    packQuaternion(&values[keys[k] * 4], &packed[k * 3]);
+            } else {
+                // Range header: min xyz, extent xyz
+                float range[6] = { values[0], values[1], values[2], 0.0f, 0.0f, 0.0f };
+                for (int key : keys)
+                    for (int c = 0; c < 3; c++)
+                        range[c] = std::min(range[c], values[key * 3 + c]);
+                for (int key : keys)
+                    for (int c = 0; c < 3; c++)
+                        range[3 + c] = std::max(range[3 + c], values[key * 3 + c] - range[c]);
+                appendBytes(out.data, range, 6);
+                for (size_t k = 0; k < keys.size(); k++)
+                    for (int c = 0; c < 3; c++) {
+                        float v = range[3 + c] > 0.0f ? (values[keys[k] * 3 + c] - range[c]) / range[3 + c] : 0.0f;
+                        packed[k * 3 + c] = (uint16_t)(v * 65535.0f + 0.5f);
+                    }
+            }
+            std::vector<uint16_t> frames(keys.begin(), keys.end());
+            appendBytes(out.data, frames.data(), frames.size());
+            appendBytes(out.data, packed.data(), packed.size());
+            // Keep every track header 4-byte aligned for the float range
+            out.data.resize((out.data.size() + 3) & ~(size_t)3);
+            out.tracks.push_back(track);
+        }
+    }
+    return out;
+}
+
+// Decodes the clip at `time` straight into a SoA pose
+void sampleCompressedClip(const CompressedClip &clip, float time, ClipCursor &cursor, PoseSoA &out) {
+    float frame = glm::clamp(time * clip.sampleRate, 0.0f, clip.duration * clip.sampleRate);
+    cursor.keys.resize(clip.tracks.size(), 0);
+    for (size_t t = 0; t < clip.tracks.size(); t++) {
+        const CompressedTrack &track = clip.tracks[t];
+        const uint8_t* p = &clip.data[track.offset];
+        const float* range = nullptr;
+        if (track.channel != CHANNEL_ROTATION) {
+            range = reinterpret_cast<const float*>(p);
+            p += 6 * sizeof(float);
+        }
+        const uint16_t* frames = reinterpret_cast<const uint16_t*>(p);
+        const uint16_t* packed = frames + track.keyCount;
+
+        uint16_t &k = cursor.keys[t];
+        if (k >= track.keyCount || frames[k] > frame)
+            k = 0; // looped or jumped backwards
+        while (k + 1 < track.keyCount && frames[k + 1] <= frame)
+            k++;
+        int k1 = std::min(k + 1, track.keyCount - 1);
+        float alpha = k1 == k ? 0.0f : (frame - frames[k]) / (float)(frames[k1] - frames[k]);
+
+        int j = track.joint;
+        if (track.channel == CHANNEL_ROTATION) {
+            float a[4], b[4];
+            unpackQuaternion(packed + k * 3, a);
+            unpackQuaternion(packed + k1 * 3, b);
+            float sign = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]) < 0.0f ? -1.0f : 1.0f;
+            float q[4], len = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                q[c] = a[c] + (b[c] * sign - a[c]) * alpha;
+                len += q[c] * q[c];
+            }
+            len = len > 0.0f ? 1.0f / sqrt(len) : 0.0f;
+            for (int c = 0; c < 4; c++)
+                out.stream(POSE_RX + c)[j] = q[c] * len;
+        } else {
+            int first = track.channel == CHANNEL_TRANSLATION ? POSE_TX : POSE_SX;
+            for (int c = 0; c < 3; c++) {
+                float a = range[c] + range[3 + c] * (packed[k * 3 + c] / 65535.0f);
+                float b = range[c] + range[3 + c] * (packed[k1 * 3 + c] / 65535.0f);
+                out.stream(first + c)[j] = a + (b - a) * alpha;
+            }
+        }
+    }
+}
+
+#endif // ANIM_COMPRESS_HPP_
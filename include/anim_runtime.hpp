@@ -0,0 +1,218 @@
+#ifndef ANIM_RUNTIME_HPP_
+#define ANIM_RUNTIME_HPP_
+#include "./anim_compress.hpp"
+#include "./jobs.hpp"
+#include <chrono>
+
+struct AnimationLayer {
+    const SampledClip* clip;          // either a resampled clip...
+    const CompressedClip* compressed; // ...or a compressed one
+    float duration;
+    float time;
+    float speed;
+    float weight; // ignored for the first layer
+    ClipCursor cursor;
+
+    void sample(PoseSoA &out) {
+        if (compressed)
+            sampleCompressedClip(*compressed, time, cursor, out);
+        else
+            sampleClip(*clip, time, out);
+    }
+};
+
+// Update rate levels: LOD n re-evaluates the pose every 2^n frames
+const int ANIMATION_LOD_COUNT = 4;
+
+struct AnimationLodSettings {
+    // Projected radius (fraction of half the screen height) below which a character drops a level
+    float screenSize[ANIMATION_LOD_COUNT - 1] = { 0.15f, 0.06f, 0.03f };
+    bool enabled = true;
+};
+
+struct AnimationFrameStats {
+    int evaluated;    // clips sampled this frame
+    int interpolated; // poses blended between two earlier evaluations
+    int perLod[ANIMATION_LOD_COUNT];
+};
+
+struct AnimatedCharacter {
+    const Skeleton* skeleton;
+    std::vector<AnimationLayer> layers;
+    PoseSoA pose, layerPose;
+    std::vector<glm::mat4> modelSpace;
+    std::vector<glm::mat4> palette;
+
+    // Update rate LOD
+    glm::vec3 position; // world space, set by the owner every frame
+    float radius;       // bounding sphere used for the projected size
+    int lod;
+    int phase;          // staggers characters of the same LOD across frames
+    PoseSoA fromPose, toPose;
+    float blendTime, blendDuration; // blendDuration 0 means no evaluation has run yet
+    float lead;                     // seconds the layers' time is ahead of the displayed pose
+
+    void evaluate(float deltaTime) {
+        if (layers.empty())
+            return;
+        // Back from a higher LOD the layers sit at toPose's time; rewind to what was shown
+        if (lead != 0.0f) {
+            advance(-lead);
+            lead = 0.0f;
+        }
+        advance(deltaTime);
+        sampleLayers(pose);
+        poseToPalette(*skeleton, pose, modelSpace, palette);
+    }
+
+    // Advances to the current frame, then samples the pose `interval` seconds ahead;
+    // interpolate() walks towards it until the next evaluation
+    void evaluateAhead(float deltaTime, float interval) {
+        if (layers.empty())
+            return;
+        if (blendDuration > 0.0f) {
+            // The layers are `lead` ahead of the shown pose; negative once the blend overran
+            blendTime += deltaTime;
+            lead -= deltaTime;
+            blendPoses(fromPose, toPose, std::min(blendTime / blendDuration, 1.0f));
+            advance(interval - lead);
+        } else {
+            advance(deltaTime);
+            sampleLayers(fromPose);
+            advance(interval);
+        }
+        sampleLayers(toPose);
+        blendTime = 0.0f;
+        blendDuration = interval;
+        lead = interval;
+        pose.data = fromPose.data;
+        poseToPalette(*skeleton, pose, modelSpace, palette);
+    }
+
+    void interpolate(float deltaTime) {
+        if (layers.empty() || blendDuration <= 0.0f)
+            return;
+        blendTime += deltaTime;
+        lead -= deltaTime;
+        pose.data = fromPose.data;
+        blendPoses(pose, toPose, std::min(blendTime / blendDuration, 1.0f));
+        poseToPalette(*skeleton, pose, modelSpace, palette);
+    }
+
+private:
+    void advance(float deltaTime) {
+        for (AnimationLayer &layer : layers)
+            if (layer.duration > 0.0f) {
+                layer.time = fmod(layer.time + deltaTime * layer.speed, layer.duration);
+                if (layer.time < 0.0f)
+                    layer.time += layer.duration;
+            }
+    }
+
+    void sampleLayers(PoseSoA &out) {
+        layers[0].sample(out);
+        for (size_t i = 1; i < layers.size(); i++) {
+            if (layers[i].weight <= 0.0f)
+                continue;
+            layers[i].sample(layerPose);
+            blendPoses(out, layerPose, layers[i].weight);
+        }
+    }
+};
+
+// Evaluates every character on the job system. Characters that are small on screen are
+// sampled every 2nd/4th/8th frame, staggered by phase so the cost stays flat from frame to
+// frame, and their pose is interpolated in between.
+class AnimationRuntime {
+public:
+    std::vector<AnimatedCharacter> characters;
+    AnimationLodSettings lodSettings;
+    AnimationFrameStats lastStats;
+    float lastUpdateMs;
+
+    AnimationRuntime(JobSystem &jobSystem) : lastStats(), lastUpdateMs(0.0f), jobSystem(jobSystem), frameIndex(0) {}
+
+    int addCharacter(const Skeleton &skeleton, const SampledClip &clip, float startTime = 0.0f) {
+        return addCharacter(skeleton, { &clip, nullptr, clip.duration, startTime, 1.0f, 1.0f, ClipCursor() });
+    }
+
+    int addCharacter(const Skeleton &skeleton, const CompressedClip &clip, float startTime = 0.0f) {
+        return addCharacter(skeleton, { nullptr, &clip, clip.duration, startTime, 1.0f, 1.0f, ClipCursor() });
+    }
+
+    int addCharacter(const Skeleton &skeleton, const AnimationLayer &baseLayer) {
+        MemoryScope memory(MEM_ANIMATION);
+        AnimatedCharacter character;
+        character.skeleton = &skeleton;
+        character.layers.push_back(baseLayer);
+        character.pose.resize((int)skeleton.joints.size());
+        character.layerPose.resize((int)skeleton.joints.size());
+        character.fromPose.resize((int)skeleton.joints.size());
+        character.toPose.resize((int)skeleton.joints.size());
+        character.position = glm::vec3(0.0f);
+        character.radius = 1.0f;
+        character.lod = 0;
+        character.phase = (int)characters.size();
+        character.blendTime = 0.0f;
+        character.blendDuration = 0.0f;
+        character.lead = 0.0f;
+        characters.push_back(character);
+        return (int)characters.size() - 1;
+    }
+
+    // fovY in degrees, as in Camera::Zoom
+    void update(float deltaTime, glm::vec3 cameraPosition, float fovY) {
+        auto start = std::chrono::steady_clock::now();
+        float projection = 1.0f / tan(glm::radians(fovY) * 0.5f);
+        AnimationFrameStats stats = AnimationFrameStats();
+        for (AnimatedCharacter &character : characters) {
+            int lod = 0;
+            if (lodSettings.enabled) {
+                float distance = std::max(glm::length(character.position - cameraPosition), 0.01f);
+                float screenSize = character.radius / distance * projection;
+                while (lod < ANIMATION_LOD_COUNT - 1 && screenSize < lodSettings.screenSize[lod])
+                    lod++;
+            }
+            character.lod = lod;
+            stats.perLod[lod]++;
+        }
+
+        jobs.clear();
+        for (int i = 0; i < (int)characters.size(); i++) {
+            const AnimatedCharacter &character = characters[i];
+            int interval = 1 << character.lod;
+            bool due = character.lod == 0 || character.blendDuration <= 0.0f || ((frameIndex + character.phase) & (interval - 1)) == 0;
+            jobs.push_back(due ? i : -1 - i); // negative: interpolate only
+            if (due)
+                stats.evaluated++;
+            else
+                stats.interpolated++;
+        }
+        jobSystem.parallel_for((int)jobs.size(), 4, [&](int begin, int end) {
+            for (int j = begin; j < end; j++) {
+                int i = jobs[j];
+                if (i < 0) {
+                    characters[-1 - i].interpolate(deltaTime);
+                    continue;
+                }
+                AnimatedCharacter &character = characters[i];
+                if (character.lod == 0) {
+                    character.evaluate(deltaTime);
+                    character.blendDuration = 0.0f;
+                } else {
+                    character.evaluateAhead(deltaTime, deltaTime * (1 << character.lod));
+                }
+            }
+        });
+        frameIndex++;
+        lastStats = stats;
+        lastUpdateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    JobSystem &jobSystem;
+    std::vector<int> jobs;
+    unsigned int frameIndex;
+};
+
+#endif // ANIM_RUNTIME_HPP_
@@ -0,0 +1,269 @@
+#ifndef ANIMATION_HPP_
+#define ANIMATION_HPP_
+#include "./skeleton.hpp"
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+// Structure-of-arrays animation runtime. Every pose stream (tx, ty, tz, rx, ry, rz, rw,
+// sx, sy, sz) is a contiguous float array over joints, padded to a multiple of 4, so the
+// sampling and blending kernels work on four joints per SSE instruction. Builds without
+// SSE2 fall back to the scalar loops.
+
+enum PoseStream { POSE_TX, POSE_TY, POSE_TZ, POSE_RX, POSE_RY, POSE_RZ, POSE_RW, POSE_SX, POSE_SY, POSE_SZ, POSE_STREAM_COUNT };
+
+inline int padJoints(int count) { return (count + 3) & ~3; }
+
+struct PoseSoA {
+    int jointCount;
+    int stride; // padded joint count
+    std::vector<float> data;
+
+    PoseSoA(int joints = 0) { resize(joints); }
+
+    void resize(int joints) {
+        jointCount = joints;
+        stride = padJoints(joints);
+        data.assign((size_t)stride * POSE_STREAM_COUNT, 0.0f);
+    }
+
+    float* stream(int s) { return &data[(size_t)s * stride]; }
+    const float* stream(int s) const { return &data[(size_t)s * stride]; }
+};
+
+// Splits a node transform into translation / rotation / scale
+inline void decomposeTransform(const glm::mat4 &m, glm::vec3 &t, glm::quat &r, glm::vec3 &s) {
+    t = glm::vec3(m[3]);
+    s = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+    glm::mat4 rotation(glm::vec4(glm::vec3(m[0]) / s.x, 0.0f),
+                       glm::vec4(glm::vec3(m[1]) / s.y, 0.0f),
+                       glm::vec4(glm::vec3(m[2]) / s.z, 0.0f),
+                       glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    r = glm::normalize(glm::quat_cast(rotation));
+}
+
+// Clip resampled at a fixed rate into SoA frames: sampling becomes two frame lookups and a
+// lerp across all joints instead of a key search per joint and channel.
+struct SampledClip {
+    std::string name;
+    float duration;
+    float sampleRate;
+    int frameCount;
+    int stride;
+    std::vector<float> frames; // frameCount * POSE_STREAM_COUNT * stride
+
+    const float* stream(int frame, int s) const {
+        return &frames[((size_t)frame * POSE_STREAM_COUNT + s) * stride];
+    }
+
+    static SampledClip fromClip(const Skeleton &skeleton, const AnimationClip &clip, float rate = 30.0f) {
+        SampledClip out;
+        out.name = clip.name;
+        out.duration = clip.duration;
+        out.sampleRate = rate;
+        out.frameCount = std::max(2, (int)ceil(clip.duration * rate) + 1);
+        out.stride = padJoints((int)skeleton.joints.size());
+        out.frames.assign((size_t)out.frameCount * POSE_STREAM_COUNT * out.stride, 0.0f);
+
+        for (int f = 0; f < out.frameCount; f++) {
+            float time = std::min(f / rate, clip.duration);
+            float* base = &out.frames[(size_t)f * POSE_STREAM_COUNT * out.stride];
+            for (size_t j = 0; j < skeleton.joints.size(); j++) {
+                glm::vec3 t, s;
+                glm::quat r;
+                decomposeTransform(skeleton.joints[j].bindLocal, t, r, s);
+                const JointTrack &track = clip.tracks[j];
+                if (!track.positions.empty())
+                    t = sampleKeys(track.positions, time);
+                if (!track.rotations.empty())
+                    r = sampleKeys(track.rotations, time);
+                if (!track.scales.empty())
+                    s = sampleKeys(track.scales, time);
+                // Keep neighbouring frames in the same hemisphere so nlerp never takes the long way
+                if (f > 0) {
+                    const float* prev = base - (size_t)POSE_STREAM_COUNT * out.stride;
+                    float d = prev[POSE_RX * out.stride + j] * r.x + prev[POSE_RY * out.stride + j] * r.y +
+                              prev[POSE_RZ * out.stride + j] * r.z + prev[POSE_RW * out.stride + j] * r.w;
+                    if (d < 0.0f)
+                        r = glm::quat(-r.w, -r.x, -r.y, -r.z);
+                }
+                const float values[POSE_STREAM_COUNT] = { t.x, t.y, t.z, r.x, r.y, r.z, r.w, s.x, s.y, s.z };
+                for (int k = 0; k < POSE_STREAM_COUNT; k++)
+                    base[k * out.stride + j] = values[k];
+            }
+        }
+        return out;
+    }
+};
+
+// out = a + (b - a) * t over `count` floats
+inline void lerpStream(float* out, const float* a, const float* b, float t, int count) {
+    int i = 0;
+#if defined(__SSE2__)
+    __m128 vt = _mm_set1_ps(t);
+    for (; i + 4 <= count; i += 4) {
+        __m128 va = _mm_loadu_ps(a + i);
+        __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt)));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+// Normalized lerp of the rotation streams, flipping b into a's hemisphere per joint
+inline void nlerpRotations(PoseSoA &out, const float* const a[4], const float* const b[4], float t, int count) {
+    float* ox = out.stream(POSE_RX);
+    float* oy = out.stream(POSE_RY);
+    float* oz = out.stream(POSE_RZ);
+    float* ow = out.stream(POSE_RW);
+    int i = 0;
+#if defined(__SSE2__)
+    __m128 vt = _mm_set1_ps(t);
+    __m128 zero = _mm_setzero_ps();
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 ax = _mm_loadu_ps(a[0] + i), ay = _mm_loadu_ps(a[1] + i), az = _mm_loadu_ps(a[2] + i), aw = _mm_loadu_ps(a[3] + i);
+        __m128 bx = _mm_loadu_ps(b[0] + i), by = _mm_loadu_ps(b[1] + i), bz = _mm_loadu_ps(b[2] + i), bw = _mm_loadu_ps(b[3] + i);
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signMask);
+        bx = _mm_xor_ps(bx, flip); by = _mm_xor_ps(by, flip); bz = _mm_xor_ps(bz, flip); bw = _mm_xor_ps(bw, flip);
+        __m128 x = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), vt));
+        __m128 y = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), vt));
+        __m128 z = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), vt));
+        __m128 w = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), vt));
+        __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+        // Padding lanes are all zero, keep them at zero instead of dividing by it
+        __m128 inv = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), len), _mm_cmpgt_ps(len, zero));
+        _mm_storeu_ps(ox + i, _mm_mul_ps(x, inv));
+        _mm_storeu_ps(oy + i, _mm_mul_ps(y, inv));
+        _mm_storeu_ps(oz + i, _mm_mul_ps(z, inv));
+        _mm_storeu_ps(ow + i, _mm_mul_ps(w, inv));
+    }
+#endif
+    for (; i < count; i++) {
+        float sign = (a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i]) < 0.0f ? -1.0f : 1.0f;
+        float x = a[0][i] + (b[0][i] * sign - a[0][i]) * t;
+        float y = a[1][i] + (b[1][i] * sign - a[1][i]) * t;
+        float z = a[2][i] + (b[2][i] * sign - a[2][i]) * t;
+        float w = a[3][i] + (b[3][i] * sign - a[3][i]) * t;
+        float len = sqrt(x * x + y * y + z * z + w * w);
+        float inv = len > 0.0f ? 1.0f / len : 0.0f;
+        ox[i] = x * inv; oy[i] = y * inv; oz[i] = z * inv; ow[i] = w * inv;
+    }
+}
+
+void sampleClip(const SampledClip &clip, float time, PoseSoA &out) {
+    float frame = glm::clamp(time * clip.sampleRate, 0.0f, (float)(clip.frameCount - 1));
+    int f0 = std::min((int)frame, clip.frameCount - 2);
+    float t = frame - f0;
+    int count = out.stride;
+    for (int s : { POSE_TX, POSE_TY, POSE_TZ, POSE_SX, POSE_SY, POSE_SZ })
+        lerpStream(out.stream(s), clip.stream(f0, s), clip.stream(f0 + 1, s), t, count);
+    const float* const a[4] = { clip.stream(f0, POSE_RX), clip.stream(f0, POSE_RY), clip.stream(f0, POSE_RZ), clip.stream(f0, POSE_RW) };
+    const float* const b[4] = { clip.stream(f0 + 1, POSE_RX), clip.stream(f0 + 1, POSE_RY), clip.stream(f0 + 1, POSE_RZ), clip.stream(f0 + 1, POSE_RW) };
+    nlerpRotations(out, a, b, t, count);
+}
+
+// out = blend(out, layer, weight), in place
+void blendPoses(PoseSoA &out, const PoseSoA &layer, float weight) {
+    int count = out.stride;
+    for (int s : { POSE_TX, POSE_TY, POSE_TZ, POSE_SX, POSE_SY, POSE_SZ })
+        lerpStream(out.stream(s), out.stream(s), layer.stream(s), weight, count);
+    const float* const a[4] = { out.stream(POSE_RX), out.stream(POSE_RY), out.stream(POSE_RZ), out.stream(POSE_RW) };
+    const float* const b[4] = { layer.stream(POSE_RX), layer.stream(POSE_RY), layer.stream(POSE_RZ), layer.stream(POSE_RW) };
+    nlerpRotations(out, a, b, weight, count);
+}
+
+// Builds column-major local matrices (16 floats per joint) from the SoA pose
+void composeLocalMatrices(const PoseSoA &pose, float* matrices) {
+    const float* tx = pose.stream(POSE_TX); const float* ty = pose.stream(POSE_TY); const float* tz = pose.stream(POSE_TZ);
+    const float* qx = pose.stream(POSE_RX); const float* qy = pose.stream(POSE_RY); const float* qz = pose.stream(POSE_RZ); const float* qw = pose.stream(POSE_RW);
+    const float* sx = pose.stream(POSE_SX); const float* sy = pose.stream(POSE_SY); const float* sz = pose.stream(POSE_SZ);
+    int j = 0;
+#if defined(__SSE2__)
+    __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+    for (; j + 4 <= pose.stride; j += 4) {
+        __m128 x = _mm_loadu_ps(qx + j), y = _mm_loadu_ps(qy + j), z = _mm_loadu_ps(qz + j), w = _mm_loadu_ps(qw + j);
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+        __m128 vsx = _mm_loadu_ps(sx + j), vsy = _mm_loadu_ps(sy + j), vsz = _mm_loadu_ps(sz + j);
+
+        // One register per matrix element, lanes are joints; transposed into per-joint columns below
+        __m128 col[4][4];
+        col[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), vsx);
+        col[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), vsx);
+        col[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), vsx);
+        col[0][3] = zero;
+        col[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), vsy);
+        col[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), vsy);
+        col[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), vsy);
+        col[1][3] = zero;
+        col[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), vsz);
+        col[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), vsz);
+        col[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), vsz);
+        col[2][3] = zero;
+        col[3][0] = _mm_loadu_ps(tx + j);
+        col[3][1] = _mm_loadu_ps(ty + j);
+        col[3][2] = _mm_loadu_ps(tz + j);
+        col[3][3] = one;
+
+        for (int c = 0; c < 4; c++) {
+            __m128 r0 = col[c][0], r1 = col[c][1], r2 = col[c][2], r3 = col[c][3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(matrices + (j + 0) * 16 + c * 4, r0);
+            _mm_storeu_ps(matrices + (j + 1) * 16 + c * 4, r1);
+            _mm_storeu_ps(matrices + (j + 2) * 16 + c * 4, r2);
+            _mm_storeu_ps(matrices + (j + 3) * 16 + c * 4, r3);
+        }
+    }
+#endif
+    for (; j < pose.stride; j++) {
+        float x = qx[j], y = qy[j], z = qz[j], w = qw[j];
+        float* m = matrices + j * 16;
+        m[0] = (1.0f - 2.0f * (y * y + z * z)) * sx[j]; m[1] = 2.0f * (x * y + w * z) * sx[j]; m[2] = 2.0f * (x * z - w * y) * sx[j]; m[3] = 0.0f;
+        m[4] = 2.0f * (x * y - w * z) * sy[j]; m[5] = (1.0f - 2.0f * (x * x + z * z)) * sy[j]; m[6] = 2.0f * (y * z + w * x) * sy[j]; m[7] = 0.0f;
+        m[8] = 2.0f * (x * z + w * y) * sz[j]; m[9] = 2.0f * (y * z - w * x) * sz[j]; m[10] = (1.0f - 2.0f * (x * x + y * y)) * sz[j]; m[11] = 0.0f;
+        m[12] = tx[j]; m[13] = ty[j]; m[14] = tz[j]; m[15] = 1.0f;
+    }
+}
+
+// out = a * b for column-major 4x4 matrices; out may not alias b
+inline void multiplyMatrices(const float* a, const float* b, float* out) {
+#if defined(__SSE2__)
+    __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    for (int c = 0; c < 4; c++) {
+        const float* bc = b + c * 4;
+        __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bc[0])), _mm_mul_ps(a1, _mm_set1_ps(bc[1]))),
+                              _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bc[2])), _mm_mul_ps(a3, _mm_set1_ps(bc[3]))));
+        _mm_storeu_ps(out + c * 4, r);
+    }
+#else
+    float tmp[16];
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            tmp[c * 4 + r] = a[r] * b[c * 4] + a[4 + r] * b[c * 4 + 1] + a[8 + r] * b[c * 4 + 2] + a[12 + r] * b[c * 4 + 3];
+    std::copy(tmp, tmp + 16, out);
+#endif
+}
+
+// Local pose -> model space -> skinning palette. Joints are parent-first, so one pass suffices.
+void poseToPalette(const Skeleton &skeleton, const PoseSoA &pose, std::vector<glm::mat4> &model, std::vector<glm::mat4> &palette) {
+    model.resize(pose.stride);
+    palette.resize(skeleton.inverseBind.size());
+    float* m = &model[0][0][0];
+    composeLocalMatrices(pose, m);
+    float local[16];
+    for (int j = 0; j < pose.jointCount; j++) {
+        const Joint &joint = skeleton.joints[j];
+        std::copy(m + j * 16, m + j * 16 + 16, local);
+        // The root carries the global inverse, so it propagates down the hierarchy for free
+        const float* parent = joint.parent < 0 ? &skeleton.globalInverse[0][0] : m + joint.parent * 16;
+        multiplyMatrices(parent, local, m + j * 16);
+        if (joint.bone >= 0)
+            multiplyMatrices(m + j * 16, &skeleton.inverseBind[joint.bone][0][0], &palette[joint.bone][0][0]);
+    }
+}
+
+#endif // ANIMATION_HPP_
@@ -0,0 +1,169 @@
+#ifndef BENCHMARK_HPP_
+#define BENCHMARK_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./render_stats.hpp"
+#include "./memory_tracker.hpp"
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Headless benchmark run (--benchmark): a fixed number of frames on a synthetic clock,
+// so every run simulates the same ticks and flies the camera along the same path
+// whatever the frame rate. The first warmupFrames are not measured (shader compiles,
+// pool allocation, first chunk meshes). Samples are per frame and go to a JSON report
+// with p50/p95/p99/max per series.
+// The main thread drives the run; the render thread adds its own samples.
+
+struct BenchmarkSeries {
+    std::string name;
+    std::vector<float> samples; // ms
+};
+
+enum BenchmarkSeriesId { BENCH_FRAME, BENCH_MAIN_THREAD, BENCH_RENDER_THREAD, BENCH_GPU, BENCH_SERIES_COUNT };
+
+class Benchmark {
+public:
+    int frames;
+    int warmupFrames;
+    double step; // seconds of simulated time per frame
+    std::string reportPath;
+
+    Benchmark() : frames(0), warmupFrames(60), step(1.0 / 60.0), reportPath("benchmark.json"), frame(0), measuring(false),
+                  passSum(0), renderFrames(0) {
+        const char* names[BENCH_SERIES_COUNT] = { "frame", "mainThread", "renderThread", "gpu" };
+        for (int i = 0; i < BENCH_SERIES_COUNT; i++)
+            series[i].name = names[i];
+    }
+
+    bool active() const { return frames > 0; }
+    bool finished() const { return frame >= warmupFrames + frames; }
+
+    // Synthetic clock for the simulation, half a step ahead so rounding never drops a tick
+    double clock() const {
+        return frame == 0 ? 0.0 : (frame + 0.5) * step;
+    }
+
+    // 0..1 over the whole run, drives the camera path
+    float progress() const {
+        return (float)frame / std::max(warmupFrames + frames - 1, 1);
+    }
+
+    // Main thread, once per frame after its samples were added
+    void nextFrame() {
+        frame++;
+        measuring = frame >= warmupFrames;
+    }
+
+    // Any thread; dropped during warmup
+    void add(BenchmarkSeriesId id, float ms) {
+        if (!measuring)
+            return;
+        std::lock_guard<std::mutex> lock(samplesMutex);
+        series[id].samples.push_back(ms);
+    }
+
+    // Render thread, once per frame
+    void addRenderFrame(int passes, const RenderCounters &counters) {
+        if (!measuring)
+            return;
+        std::lock_guard<std::mutex> lock(samplesMutex);
+        passSum += passes;
+        renderSum += counters;
+        renderFrames++;
+    }
+
+    bool writeReport(const std::string &renderer, int width, int height) {
+        std::ofstream file(reportPath);
+        if (!file) {
+            std::cerr << "ERROR::BENCHMARK::CANNOT_WRITE " << reportPath << std::endl;
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(samplesMutex);
+        file << "{\n  \"renderer\": \"" << escape(renderer) << "\",\n";
+        file << "  \"width\": " << width << ", \"height\": " << height << ",\n";
+        file << "  \"frames\": " << frames << ", \"warmupFrames\": " << warmupFrames << ",\n";
+        for (BenchmarkSeries &s : series) {
+            std::vector<float> sorted = s.samples;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (float ms : sorted)
+                sum += ms;
+            char buffer[256];
+            std::snprintf(buffer, sizeof(buffer),
+                          "  \"%sMs\": { \"samples\": %d, \"avg\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f },\n",
+                          s.name.c_str(), (int)sorted.size(), sorted.empty() ? 0.0 : sum / sorted.size(),
+                          percentile(sorted, 0.50f), percentile(sorted, 0.95f), percentile(sorted, 0.99f),
+                          sorted.empty() ? 0.0f : sorted.back());
+            file << buffer;
+        }
+        double frameCount = std::max(renderFrames, 1);
+        file << "  \"perFrame\": { \"renderPasses\": " << passSum / frameCount << ", \"draws\": " << renderSum.draws / frameCount
+             << ", \"triangles\": " << renderSum.triangles / frameCount << ", \"programBinds\": " << renderSum.programBinds / frameCount
+             << ", \"vertexArrayBinds\": " << renderSum.vertexArrayBinds / frameCount << ", \"textureBinds\": " << renderSum.textureBinds / frameCount
+             << ", \"uniformCalls\": " << renderSum.uniformCalls / frameCount << ", \"bufferUploadBytes\": " << renderSum.bufferUploadBytes / frameCount
+             << ", \"textureUploadBytes\": " << renderSum.textureUploadBytes / frameCount << " },\n";
+        MemoryStats memory = MemoryTracker::instance().stats();
+        file << "  \"memory\": { \"budgetBytes\": " << MEMORY_BUDGET_BYTES << ", \"cpuBytes\": " << memory.cpuTotal << ", \"cpuPeakBytes\": " << memory.cpuPeak
+             << ", \"gpuBytes\": " << memory.gpuTotal << ", \"gpuPeakBytes\": " << memory.gpuPeak << ",\n    \"subsystems\": {";
+        for (int tag = 0; tag < MEM_TAG_COUNT; tag++)
+            file << (tag ? "," : "") << "\n      \"" << memoryTagName(tag) << "\": { \"cpuBytes\": " << memory.cpu[tag].current
+                 << ", \"cpuPeakBytes\": " << memory.cpu[tag].peak << ", \"gpuBytes\": " << memory.gpu[tag].current
+                 << ", \"gpuPeakBytes\": " << memory.gpu[tag].peak << " }";
+        file << "\n    } },\n";
+        file << "  \"peakResidentBytes\": " << peakResidentBytes() << "\n}\n";
+        std::cout << "Benchmark report written: " << reportPath << std::endl;
+        return true;
+    }
+
+private:
+    int frame;
+    std::atomic<bool> measuring;
+    std::mutex samplesMutex;
+    BenchmarkSeries series[BENCH_SERIES_COUNT];
+    long long passSum;
+    RenderCounters renderSum;
+    int renderFrames;
+
+    // Nearest rank over sorted samples
+    static float percentile(const std::vector<float> &sorted, float p) {
+        if (sorted.empty())
+            return 0.0f;
+        size_t rank = (size_t)std::ceil(p * sorted.size());
+        return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+    }
+
+    static std::string escape(const std::string &text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    // 0 where the platform does not report it
+    static long long peakResidentBytes() {
+#if defined(__linux__)
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return (long long)usage.ru_maxrss * 1024; // kilobytes on Linux
+#elif defined(__APPLE__)
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return (long long)usage.ru_maxrss;
+#else
+        return 0;
+#endif
+    }
+};
+
+#endif // BENCHMARK_HPP_
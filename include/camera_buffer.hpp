@@ -0,0 +1,66 @@
+#ifndef CAMERA_BUFFER_HPP_
+#define CAMERA_BUFFER_HPP_
+#include <mutex>
+#include "./memory_tracker.hpp"
+
+// Matches the std140 "Camera" uniform block declared by every vertex/geometry shader
+const GLuint CAMERA_BINDING = 1;
+
+struct CameraState {
+    glm::mat4 view;
+    glm::mat4 projection;
+    double inputTime; // glfwGetTime() of the newest input folded into view
+};
+
+// Late latch: the main thread stores the newest camera whenever it has polled input,
+// the render thread loads it right before submitting draws. While the render thread
+// draws frame N the main thread is already polling for frame N+1, so the camera that
+// reaches the screen is up to a frame newer than the rest of the snapshot.
+class CameraLatch {
+public:
+    CameraLatch() : latest() {}
+
+    void store(const CameraState &state) {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = state;
+    }
+
+    CameraState load() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return latest;
+    }
+
+private:
+    std::mutex mutex;
+    CameraState latest;
+};
+
+// One uniform buffer shared by all shaders, written once per frame
+class CameraBuffer {
+public:
+    GLuint UBO;
+
+    CameraBuffer() {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+        MemoryTracker::instance().gpuAllocated(MEM_RENDERER, GPU_BUFFER, UBO, 2 * sizeof(glm::mat4));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, UBO);
+    }
+
+    void upload(const CameraState &state) {
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), &state.view[0][0]);
+        glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), &state.projection[0][0]);
+        RenderStats::instance().bufferUpload(2 * sizeof(glm::mat4));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void destroy() {
+        MemoryTracker::instance().gpuFreed(GPU_BUFFER, UBO);
+        glDeleteBuffers(1, &UBO);
+    }
+};
+
+#endif // CAMERA_BUFFER_HPP_
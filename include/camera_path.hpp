@@ -0,0 +1,83 @@
+#ifndef CAMERA_PATH_HPP_
+#define CAMERA_PATH_HPP_
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Camera fly-through for benchmarks: key poses joined by a Catmull-Rom spline, so the
+// camera passes through every key with a continuous velocity. Keys are recorded in the
+// running game (append() per key press, save() writes them) and read back with load();
+// the file is one "x y z yaw pitch" line per key.
+
+struct CameraKey {
+    glm::vec3 position;
+    float yaw, pitch;
+};
+
+class CameraPath {
+public:
+    std::vector<CameraKey> keys;
+
+    bool load(const std::string &path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "ERROR::CAMERA_PATH::CANNOT_READ " << path << std::endl;
+            return false;
+        }
+        std::vector<CameraKey> loaded;
+        CameraKey key;
+        while (file >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch)
+            loaded.push_back(key);
+        if (loaded.size() < 2) {
+            std::cerr << "ERROR::CAMERA_PATH::NEEDS_TWO_KEYS " << path << std::endl;
+            return false;
+        }
+        keys = loaded;
+        return true;
+    }
+
+    // Appends to the file, so keys can be recorded one at a time
+    void append(const CameraKey &key, const std::string &path) {
+        keys.push_back(key);
+        std::ofstream file(path, std::ios::app);
+        if (!file) {
+            std::cerr << "ERROR::CAMERA_PATH::CANNOT_WRITE " << path << std::endl;
+            return;
+        }
+        file << key.position.x << ' ' << key.position.y << ' ' << key.position.z << ' ' << key.yaw << ' ' << key.pitch << '\n';
+    }
+
+    // t from 0 (first key) to 1 (last key), equal time between keys
+    CameraKey sample(float t) const {
+        if (keys.empty())
+            return { glm::vec3(0.0f), -90.0f, 0.0f };
+        int segments = (int)keys.size() - 1;
+        if (segments == 0)
+            return keys[0];
+        float s = std::min(std::max(t, 0.0f), 1.0f) * segments;
+        int i = std::min((int)s, segments - 1);
+        float u = s - i;
+        // Ends repeat the first and last key
+        const CameraKey &k0 = keys[std::max(i - 1, 0)];
+        const CameraKey &k1 = keys[i];
+        const CameraKey &k2 = keys[i + 1];
+        const CameraKey &k3 = keys[std::min(i + 2, segments)];
+        CameraKey key;
+        key.position = catmullRom(k0.position, k1.position, k2.position, k3.position, u);
+        key.yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, u);
+        key.pitch = std::min(std::max(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, u), -89.0f), 89.0f);
+        return key;
+    }
+
+private:
+    template <typename T>
+    static T catmullRom(const T &p0, const T &p1, const T &p2, const T &p3, float u) {
+        float u2 = u * u, u3 = u2 * u;
+        return 0.5f * ((2.0f * p1) + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+    }
+};
+
+#endif // CAMERA_PATH_HPP_
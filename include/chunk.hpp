@@ -0,0 +1,240 @@
+#ifndef CHUNK_HPP_
+#define CHUNK_HPP_
+#include "./includes.hpp"
+#include <cstdint>
+#include <bitset>
+#include "./memory_tracker.hpp"
+
+const int CHUNK_SIZE = 16;
+const int CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+const int CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+const uint8_t MAX_LIGHT = 15;
+
+enum BlockType : uint16_t {
+    BLOCK_AIR = 0,
+    BLOCK_GRASS,
+    BLOCK_DIRT,
+    BLOCK_STONE,
+    BLOCK_LAMP,
+    BLOCK_TYPE_COUNT
+};
+
+struct BlockInfo {
+    bool opaque;
+    uint8_t emission; // block light level emitted, 0 for none
+};
+
+const BlockInfo blockInfos[BLOCK_TYPE_COUNT] = {
+    { false, 0 },  // BLOCK_AIR
+    { true, 0 },   // BLOCK_GRASS
+    { true, 0 },   // BLOCK_DIRT
+    { true, 0 },   // BLOCK_STONE
+    { true, 14 },  // BLOCK_LAMP
+};
+
+inline bool isOpaque(uint16_t block) { return blockInfos[block].opaque; }
+inline uint8_t blockEmission(uint16_t block) { return blockInfos[block].emission; }
+
+// Block ids stored as indices into a small per-chunk palette, bit-packed into 64-bit words.
+// Entries never straddle a word; the index width grows when the palette outgrows it.
+class PaletteStorage {
+public:
+    std::vector<uint16_t> palette;
+    std::vector<uint64_t> words;
+    int bits;
+
+    PaletteStorage(int size, uint16_t fill) : palette(1, fill), bits(1), count(size) {
+        perWord = 64 / bits;
+        words.assign((count + perWord - 1) / perWord, 0);
+    }
+
+    uint16_t get(int i) const {
+        uint64_t word = words[i / perWord];
+        return palette[(word >> ((i % perWord) * bits)) & mask()];
+    }
+
+    void set(int i, uint16_t block) {
+        write(i, paletteIndex(block));
+    }
+
+private:
+    int count;
+    int perWord;
+
+    uint64_t mask() const { return (1ull << bits) - 1; }
+
+    int paletteIndex(uint16_t block) {
+        for (size_t k = 0; k < palette.size(); k++)
+            if (palette[k] == block)
+                return (int)k;
+        palette.push_back(block);
+        if (palette.size() > (1ull << bits))
+            resize(bits + 1);
+        return (int)palette.size() - 1;
+    }
+
+    void write(int i, int id) {
+        uint64_t &word = words[i / perWord];
+        int shift = (i % perWord) * bits;
+        word = (word & ~(mask() << shift)) | ((uint64_t)id << shift);
+    }
+
+    void resize(int newBits) {
+        std::vector<int> ids(count);
+        for (int i = 0; i < count; i++)
+            ids[i] = (int)((words[i / perWord] >> ((i % perWord) * bits)) & mask());
+        bits = newBits;
+        perWord = 64 / bits;
+        words.assign((count + perWord - 1) / perWord, 0);
+        for (int i = 0; i < count; i++)
+            write(i, ids[i]);
+    }
+};
+
+const int REGION_SIZE = 4; // dirty tracking granularity, 4x4x4 regions per chunk (one bit each)
+const int REGIONS_PER_AXIS = CHUNK_SIZE / REGION_SIZE;
+
+class Chunk {
+public:
+    glm::ivec3 coord; // chunk coordinates inside the world
+    PaletteStorage blocks;
+    std::vector<uint8_t> light; // high nibble: sky light, low nibble: block light
+    uint64_t dirtyRegions; // sub-chunk regions touched since the last remesh
+
+    Chunk(glm::ivec3 c) : coord(c), blocks(CHUNK_VOLUME, BLOCK_AIR), light(CHUNK_VOLUME, 0), dirtyRegions(~0ull) {}
+
+    static int index(int x, int y, int z) {
+        return (y * CHUNK_SIZE + z) * CHUNK_SIZE + x;
+    }
+
+    static int regionIndex(int x, int y, int z) {
+        return ((y / REGION_SIZE) * REGIONS_PER_AXIS + z / REGION_SIZE) * REGIONS_PER_AXIS + x / REGION_SIZE;
+    }
+
+    bool needsRemesh() const { return dirtyRegions != 0; }
+    int dirtyRegionCount() const { return (int)std::bitset<64>(dirtyRegions).count(); }
+
+    uint16_t getBlock(int x, int y, int z) const { return blocks.get(index(x, y, z)); }
+    void setBlock(int x, int y, int z, uint16_t block) { blocks.set(index(x, y, z), block); }
+
+    uint8_t getSkyLight(int i) const { return light[i] >> 4; }
+    uint8_t getBlockLight(int i) const { return light[i] & 0x0F; }
+    void setSkyLight(int i, uint8_t level) { light[i] = (light[i] & 0x0F) | (level << 4); }
+    void setBlockLight(int i, uint8_t level) { light[i] = (light[i] & 0xF0) | level; }
+};
+
+// Fixed box of chunks. Block coordinates are world-local, `origin` places block (0,0,0) in the scene.
+class World {
+public:
+    glm::ivec3 size; // in chunks
+    glm::ivec3 origin;
+    std::vector<Chunk> chunks;
+
+    World(glm::ivec3 sizeInChunks, glm::ivec3 worldOrigin) : size(sizeInChunks), origin(worldOrigin) {
+        MemoryScope memory(MEM_WORLD);
+        chunks.reserve(size.x * size.y * size.z);
+        for (int y = 0; y < size.y; y++)
+            for (int z = 0; z < size.z; z++)
+                for (int x = 0; x < size.x; x++)
+                    chunks.emplace_back(glm::ivec3(x, y, z));
+    }
+
+    int heightInBlocks() const { return size.y * CHUNK_SIZE; }
+
+    bool inBounds(glm::ivec3 p) const {
+        return p.x >= 0 && p.y >= 0 && p.z >= 0 &&
+               p.x < size.x * CHUNK_SIZE && p.y < size.y * CHUNK_SIZE && p.z < size.z * CHUNK_SIZE;
+    }
+
+    Chunk* getChunk(glm::ivec3 c) {
+        if (c.x < 0 || c.y < 0 || c.z < 0 || c.x >= size.x || c.y >= size.y || c.z >= size.z)
+            return nullptr;
+        return &chunks[(c.y * size.z + c.z) * size.x + c.x];
+    }
+
+    // Resolves a block position into its chunk and voxel index, nullptr when outside the world
+    Chunk* locate(glm::ivec3 p, int &index) {
+        if (!inBounds(p))
+            return nullptr;
+        Chunk* chunk = getChunk(glm::ivec3(p.x / CHUNK_SIZE, p.y / CHUNK_SIZE, p.z / CHUNK_SIZE));
+        index = Chunk::index(p.x % CHUNK_SIZE, p.y % CHUNK_SIZE, p.z % CHUNK_SIZE);
+        return chunk;
+    }
+
+    uint16_t getBlock(glm::ivec3 p) {
+        int i;
+        Chunk* chunk = locate(p, i);
+        return chunk ? chunk->blocks.get(i) : BLOCK_AIR;
+    }
+
+    // Raw write, does not touch lighting or meshes. Use LightEngine::setBlock for edits.
+    void setBlockRaw(glm::ivec3 p, uint16_t block) {
+        int i;
+        Chunk* chunk = locate(p, i);
+        if (chunk)
+            chunk->blocks.set(i, block);
+    }
+
+    // Outside the world counts as open sky
+    uint8_t getSkyLight(glm::ivec3 p) {
+        int i;
+        Chunk* chunk = locate(p, i);
+        return chunk ? chunk->getSkyLight(i) : MAX_LIGHT;
+    }
+
+    uint8_t getBlockLight(glm::ivec3 p) {
+        int i;
+        Chunk* chunk = locate(p, i);
+        return chunk ? chunk->getBlockLight(i) : 0;
+    }
+
+    // Flags the region containing p, plus the regions of neighbouring chunks when p lies
+    // on a chunk border (their faces sample light and AO across the border).
+    void markDirty(glm::ivec3 p) {
+        glm::ivec3 l(p.x % CHUNK_SIZE, p.y % CHUNK_SIZE, p.z % CHUNK_SIZE);
+        for (int dy = -1; dy <= 1; dy++) {
+            if ((dy == -1 && l.y != 0) || (dy == 1 && l.y != CHUNK_SIZE - 1))
+                continue;
+            for (int dz = -1; dz <= 1; dz++) {
+                if ((dz == -1 && l.z != 0) || (dz == 1 && l.z != CHUNK_SIZE - 1))
+                    continue;
+                for (int dx = -1; dx <= 1; dx++) {
+                    if ((dx == -1 && l.x != 0) || (dx == 1 && l.x != CHUNK_SIZE - 1))
+                        continue;
+                    markRegion(p + glm::ivec3(dx, dy, dz));
+                }
+            }
+        }
+    }
+
+private:
+    void markRegion(glm::ivec3 p) {
+        if (!inBounds(p))
+            return;
+        Chunk* chunk = getChunk(glm::ivec3(p.x / CHUNK_SIZE, p.y / CHUNK_SIZE, p.z / CHUNK_SIZE));
+        chunk->dirtyRegions |= 1ull << Chunk::regionIndex(p.x % CHUNK_SIZE, p.y % CHUNK_SIZE, p.z % CHUNK_SIZE);
+    }
+};
+
+// Simple rolling heightmap with a few lamps scattered on top
+void generateTerrain(World &world) {
+    int sx = world.size.x * CHUNK_SIZE;
+    int sz = world.size.z * CHUNK_SIZE;
+    for (int x = 0; x < sx; x++) {
+        for (int z = 0; z < sz; z++) {
+            int height = 8 + (int)(3.0f * sin(x * 0.15f) + 2.0f * cos(z * 0.2f));
+            for (int y = 0; y <= height && y < world.heightInBlocks(); y++) {
+                uint16_t block = BLOCK_STONE;
+                if (y == height)
+                    block = BLOCK_GRASS;
+                else if (y > height - 3)
+                    block = BLOCK_DIRT;
+                world.setBlockRaw(glm::ivec3(x, y, z), block);
+            }
+            if (x % 13 == 6 && z % 11 == 5)
+                world.setBlockRaw(glm::ivec3(x, height + 1, z), BLOCK_LAMP);
+        }
+    }
+}
+
+#endif // CHUNK_HPP_
@@ -0,0 +1,240 @@
+#ifndef CHUNK_MESH_HPP_
+#define CHUNK_MESH_HPP_
+#include "./chunk.hpp"
+#include "./jobs.hpp"
+#include "./frustum.hpp"
+#include "./memory_tracker.hpp"
+#include <algorithm>
+
+// Packed voxel vertex, decoded in chunkVertexShaderSource:
+//   data     bits 0-14 position (5 bits per axis, chunk-relative 0..16)
+//            bits 15-17 face normal index, 18-19 face corner (texcoord),
+//            bits 20-21 AO, 22-25 sky light, 26-29 block light
+//   material bits 0-15 texture layer (block type)
+struct ChunkVertex {
+    uint32_t data;
+    uint32_t material;
+};
+
+inline ChunkVertex packChunkVertex(glm::ivec3 pos, int normal, int corner, int ao, int sky, int blockLight, int layer) {
+    ChunkVertex vertex;
+    vertex.data = (uint32_t)pos.x | ((uint32_t)pos.y << 5) | ((uint32_t)pos.z << 10) |
+                  ((uint32_t)normal << 15) | ((uint32_t)corner << 18) | ((uint32_t)ao << 20) |
+                  ((uint32_t)sky << 22) | ((uint32_t)blockLight << 26);
+    vertex.material = (uint32_t)layer & 0xFFFF;
+    return vertex;
+}
+
+struct BlockFace {
+    glm::ivec3 normal;
+    glm::ivec3 corners[4]; // counter-clockwise seen from outside
+};
+
+const BlockFace blockFaces[6] = {
+    { glm::ivec3( 1, 0, 0), { glm::ivec3(1, 0, 0), glm::ivec3(1, 1, 0), glm::ivec3(1, 1, 1), glm::ivec3(1, 0, 1) } },
+    { glm::ivec3(-1, 0, 0), { glm::ivec3(0, 0, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 1, 1), glm::ivec3(0, 1, 0) } },
+    { glm::ivec3( 0, 1, 0), { glm::ivec3(0, 1, 0), glm::ivec3(0, 1, 1), glm::ivec3(1, 1, 1), glm::ivec3(1, 1, 0) } },
+    { glm::ivec3( 0,-1, 0), { glm::ivec3(0, 0, 0), glm::ivec3(1, 0, 0), glm::ivec3(1, 0, 1), glm::ivec3(0, 0, 1) } },
+    { glm::ivec3( 0, 0, 1), { glm::ivec3(0, 0, 1), glm::ivec3(1, 0, 1), glm::ivec3(1, 1, 1), glm::ivec3(0, 1, 1) } },
+    { glm::ivec3( 0, 0,-1), { glm::ivec3(0, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(1, 1, 0), glm::ivec3(1, 0, 0) } },
+};
+
+// Classic voxel corner occlusion: 0 (fully occluded) .. 3 (open)
+inline int vertexAO(bool side1, bool side2, bool corner) {
+    if (side1 && side2)
+        return 0;
+    return 3 - (side1 + side2 + corner);
+}
+
+// Emits the visible faces of one chunk. Light is taken from the voxel in front of
+// each face and baked into the vertices, so the shader only scales sky light by daylight.
+// Face order matches the normal table in chunkVertexShaderSource.
+// Every corner also gets its AO from the three voxels touching it in front of the face.
+void buildChunkMesh(World &world, const Chunk &chunk, std::vector<ChunkVertex> &vertices, std::vector<GLushort> &indices) {
+    vertices.clear();
+    indices.clear();
+    glm::ivec3 base = chunk.coord * CHUNK_SIZE;
+
+    auto inside = [](glm::ivec3 p) {
+        return p.x >= 0 && p.y >= 0 && p.z >= 0 && p.x < CHUNK_SIZE && p.y < CHUNK_SIZE && p.z < CHUNK_SIZE;
+    };
+    auto opaqueAt = [&](glm::ivec3 p) {
+        return isOpaque(inside(p) ? chunk.getBlock(p.x, p.y, p.z) : world.getBlock(base + p));
+    };
+
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int x = 0; x < CHUNK_SIZE; x++) {
+                uint16_t block = chunk.getBlock(x, y, z);
+                if (block == BLOCK_AIR)
+                    continue;
+                glm::ivec3 local(x, y, z);
+                for (int f = 0; f < 6; f++) {
+                    const BlockFace &face = blockFaces[f];
+                    glm::ivec3 n = local + face.normal;
+                    if (opaqueAt(n))
+                        continue;
+
+                    int sky, blockLight;
+                    if (inside(n)) {
+                        int i = Chunk::index(n.x, n.y, n.z);
+                        sky = chunk.getSkyLight(i);
+                        blockLight = chunk.getBlockLight(i);
+                    } else {
+                        sky = world.getSkyLight(base + n);
+                        blockLight = world.getBlockLight(base + n);
+                    }
+                    // Emitters are fully lit on every face
+                    blockLight = std::max(blockLight, (int)blockEmission(block));
+
+                    // Tangent axes of the face plane
+                    int axis = face.normal.x != 0 ? 0 : (face.normal.y != 0 ? 1 : 2);
+                    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+                    int ao[4];
+                    GLushort first = (GLushort)vertices.size();
+                    for (int c = 0; c < 4; c++) {
+                        glm::ivec3 du(0), dv(0);
+                        du[u] = face.corners[c][u] * 2 - 1;
+                        dv[v] = face.corners[c][v] * 2 - 1;
+                        ao[c] = vertexAO(opaqueAt(n + du), opaqueAt(n + dv), opaqueAt(n + du + dv));
+                        vertices.push_back(packChunkVertex(local + face.corners[c], f, c, ao[c], sky, blockLight, block));
+                    }
+
+                    // Split the quad along the brighter diagonal, otherwise the AO
+                    // gradient is interpolated differently on the two triangles
+                    if (ao[0] + ao[2] < ao[1] + ao[3]) {
+                        const GLushort flipped[6] = { 1, 2, 3, 1, 3, 0 };
+                        for (GLushort i : flipped)
+                            indices.push_back(first + i);
+                    } else {
+                        const GLushort regular[6] = { 0, 1, 2, 0, 2, 3 };
+                        for (GLushort i : regular)
+                            indices.push_back(first + i);
+                    }
+                }
+            }
+        }
+    }
+}
+
+class ChunkMesh {
+public:
+    GLuint VAO, VBO, EBO;
+    GLsizei indexCount;
+
+    ChunkMesh() : indexCount(0) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+        // Integer attribute, unpacked in the vertex shader
+        glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        glBindVertexArray(0);
+    }
+
+    void upload(const std::vector<ChunkVertex> &vertices, const std::vector<GLushort> &indices) {
+        indexCount = (GLsizei)indices.size();
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(ChunkVertex), vertices.data(), GL_DYNAMIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_DYNAMIC_DRAW);
+        glBindVertexArray(0);
+        RenderStats::instance().vertexArrayBind();
+        RenderStats::instance().bufferUpload(vertices.size() * sizeof(ChunkVertex) + indices.size() * sizeof(GLushort));
+        MemoryTracker::instance().gpuAllocated(MEM_WORLD, GPU_BUFFER, VBO, vertices.size() * sizeof(ChunkVertex));
+        MemoryTracker::instance().gpuAllocated(MEM_WORLD, GPU_BUFFER, EBO, indices.size() * sizeof(GLushort));
+    }
+};
+
+// Mesh built on the CPU, waiting to be uploaded by the GL thread
+struct ChunkMeshUpload {
+    int chunk;
+    std::vector<ChunkVertex> vertices;
+    std::vector<GLushort> indices;
+};
+
+// Keeps one GPU mesh per chunk and rebuilds only the chunks with dirty regions,
+// at most once per chunk per frame however many blocks changed inside it
+class WorldRenderer {
+public:
+    World &world;
+    std::vector<ChunkMesh> meshes;
+    int remeshedLastFrame;
+    int dirtyRegionsLastFrame;
+
+    WorldRenderer(World &w, JobSystem &jobs) : world(w), remeshedLastFrame(0), dirtyRegionsLastFrame(0), jobSystem(jobs) {
+        MemoryScope memory(MEM_WORLD);
+        meshes.resize(world.chunks.size());
+    }
+
+    // Simulation side: meshes dirty chunks in parallel (the world is only read) into `uploads`,
+    // whose buffers keep their capacity from frame to frame
+    void update(std::vector<ChunkMeshUpload> &uploads) {
+        remeshedLastFrame = 0;
+        dirtyRegionsLastFrame = 0;
+        dirty.clear();
+        for (size_t i = 0; i < world.chunks.size(); i++) {
+            if (!world.chunks[i].needsRemesh())
+                continue;
+            dirtyRegionsLastFrame += world.chunks[i].dirtyRegionCount();
+            dirty.push_back((int)i);
+        }
+        uploads.resize(dirty.size());
+        jobSystem.parallel_for((int)dirty.size(), 1, [&](int begin, int end) {
+            MemoryScope memory(MEM_WORLD);
+            for (int k = begin; k < end; k++) {
+                uploads[k].chunk = dirty[k];
+                buildChunkMesh(world, world.chunks[dirty[k]], uploads[k].vertices, uploads[k].indices);
+            }
+        });
+        for (int i : dirty)
+            world.chunks[i].dirtyRegions = 0;
+        remeshedLastFrame = (int)dirty.size();
+    }
+
+    // GL thread
+    void upload(const std::vector<ChunkMeshUpload> &uploads) {
+        for (const ChunkMeshUpload &mesh : uploads)
+            meshes[mesh.chunk].upload(mesh.vertices, mesh.indices);
+    }
+
+    // Chunks outside the frustum are skipped
+    void draw(Shader &shader, const Frustum &frustum = Frustum()) {
+        for (size_t i = 0; i < meshes.size(); i++) {
+            if (meshes[i].indexCount == 0)
+                continue;
+            glm::vec3 chunkOrigin = glm::vec3(world.origin + world.chunks[i].coord * CHUNK_SIZE);
+            if (!frustum.intersectsBox(chunkOrigin, chunkOrigin + glm::vec3((float)CHUNK_SIZE)))
+                continue;
+            shader.setVec3("chunkOrigin", chunkOrigin);
+            glBindVertexArray(meshes[i].VAO);
+            glDrawElements(GL_TRIANGLES, meshes[i].indexCount, GL_UNSIGNED_SHORT, 0);
+            RenderStats::instance().vertexArrayBind();
+            RenderStats::instance().draw(GL_TRIANGLES, meshes[i].indexCount);
+        }
+        glBindVertexArray(0);
+    }
+
+    void destroy() {
+        for (auto &mesh : meshes) {
+            MemoryTracker::instance().gpuFreed(GPU_BUFFER, mesh.VBO);
+            MemoryTracker::instance().gpuFreed(GPU_BUFFER, mesh.EBO);
+            glDeleteVertexArrays(1, &mesh.VAO);
+            glDeleteBuffers(1, &mesh.VBO);
+            glDeleteBuffers(1, &mesh.EBO);
+        }
+    }
+
+private:
+    JobSystem &jobSystem;
+    std::vector<int> dirty;
+};
+
+#endif // CHUNK_MESH_HPP_
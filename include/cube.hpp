@@ -5,6 +5,7 @@ class Cube {
 public:
     glm::vec3 position;
     glm::vec3 rotation;
+    glm::vec3 previousRotation; // rotation at the previous simulation tick
     glm::vec3 size;
     GLuint VAO, VBO;
     int blocktype;
@@ -12,7 +13,7 @@ public:
     float rotationSpeed; // Скорость вращения
 
     Cube(glm::vec3 pos, glm::vec3 rot, glm::vec3 s, int type, bool rotate = false, float speed = 1.0f)
-        : position(pos), rotation(rot), size(s), blocktype(type), shouldRotate(rotate), rotationSpeed(speed) {
+        : position(pos), rotation(rot), previousRotation(rot), size(s), blocktype(type), shouldRotate(rotate), rotationSpeed(speed) {
         std::vector<float> vertices = {
             // positions          // texture coords
             -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
@@ -65,6 +66,7 @@ public:
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        MemoryTracker::instance().gpuAllocated(MEM_MESHES, GPU_BUFFER, VBO, vertices.size() * sizeof(float));
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
@@ -77,25 +79,35 @@ public:
         size = newSize;
     }
 
+    // Called once per simulation tick
     void updateRotation(float deltaTime) {
+        previousRotation = rotation;
         if (shouldRotate) {
             rotation.y += rotationSpeed * deltaTime;
         }
     }
 
-    void draw(Shader &shader) {
+    // Rotation blended between the last two simulation ticks
+    glm::mat4 modelMatrix(float alpha = 1.0f) const {
+        glm::vec3 angles = glm::mix(previousRotation, rotation, alpha);
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, position);
-        model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::rotate(model, glm::radians(angles.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(angles.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(angles.z), glm::vec3(0.0f, 0.0f, 1.0f));
         model = glm::scale(model, size);
+        return model;
+    }
 
-        shader.setMat4("model", model);
+    // alpha blends between the last two simulation ticks
+    void draw(Shader &shader, float alpha = 1.0f) {
+        shader.setMat4("model", modelMatrix(alpha));
         shader.setInt("cubeType", blocktype);
 
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
+        RenderStats::instance().vertexArrayBind();
+        RenderStats::instance().draw(GL_TRIANGLES, 36);
     }
 };
 
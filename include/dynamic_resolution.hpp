@@ -0,0 +1,101 @@
+#ifndef DYNAMIC_RESOLUTION_HPP_
+#define DYNAMIC_RESOLUTION_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+// Dynamic resolution: the 3D passes render into an offscreen target at `scale` times
+// the window size, then composite() upscales it to the window before ImGui draws at
+// native resolution. The scale follows the GPU frame time reported by the pass timers
+// (GpuTimers, read back a few frames late so the CPU never waits on them):
+// over budget it drops at once (pixel count, and roughly GPU time, goes with scale^2),
+// well under budget it creeps back up so the resolution does not oscillate.
+// The render graph allocates the target at window size and renders into its scaled
+// corner, so changing the scale never reallocates.
+// All methods except settings and stats() run on the thread that owns the GL context.
+
+struct DynamicResolutionStats {
+    float scale;
+    float gpuMs;    // last measured frame
+    float gpuMsAvg;
+    int width, height; // render size
+};
+
+class DynamicResolution {
+public:
+    std::atomic<bool> enabled;
+    std::atomic<float> budgetMs;  // GPU time a frame may take
+    std::atomic<float> minScale;
+    std::atomic<float> sharpness; // 0 for a plain bilinear upscale
+
+    DynamicResolution(Shader &upscale)
+        : enabled(true), budgetMs(12.0f), minScale(0.5f), sharpness(0.3f), upscaleShader(upscale),
+          renderWidth(1), renderHeight(1), scale(1.0f), current() {
+        glGenVertexArrays(1, &emptyVAO);
+        current.scale = 1.0f;
+    }
+
+    // Size the scene passes render at this frame
+    void renderSize(int windowWidth, int windowHeight, int &width, int &height) {
+        float s = enabled ? scale : 1.0f;
+        renderWidth = width = std::max(1, (int)(std::max(windowWidth, 1) * s));
+        renderHeight = height = std::max(1, (int)(std::max(windowHeight, 1) * s));
+    }
+
+    // Upscales `scene` into the bound framebuffer. uvScale: rendered part of the texture,
+    // textureSize: its allocated size
+    void composite(GLuint scene, glm::vec2 uvScale, glm::vec2 textureSize) {
+        upscaleShader.use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, scene);
+        RenderStats::instance().textureBind();
+        upscaleShader.setInt("scene", 0);
+        upscaleShader.setVec2("uvScale", uvScale);
+        upscaleShader.setVec2("texelSize", 1.0f / textureSize);
+        upscaleShader.setFloat("sharpness", uvScale.x < 1.0f ? sharpness.load() : 0.0f);
+        glBindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        RenderStats::instance().vertexArrayBind();
+        RenderStats::instance().draw(GL_TRIANGLES, 3);
+        glBindVertexArray(0);
+    }
+
+    DynamicResolutionStats stats() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return current;
+    }
+
+    void destroy() {
+        glDeleteVertexArrays(1, &emptyVAO);
+    }
+
+    // Steers the scale with a measured GPU frame time
+    void reportGpuTime(float gpuMs) {
+        if (enabled) {
+            float budget = budgetMs;
+            if (gpuMs > budget)
+                scale *= std::max(std::sqrt(budget / gpuMs), 0.85f);
+            else if (gpuMs < budget * 0.8f)
+                scale += 0.01f;
+            scale = std::min(std::max(scale, minScale.load()), 1.0f);
+        }
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        current.gpuMs = gpuMs;
+        current.gpuMsAvg += (gpuMs - current.gpuMsAvg) * 0.05f;
+        current.scale = enabled ? scale : 1.0f;
+        current.width = renderWidth;
+        current.height = renderHeight;
+    }
+
+private:
+    Shader &upscaleShader;
+    GLuint emptyVAO;
+    int renderWidth, renderHeight;
+    float scale;
+    std::mutex statsMutex;
+    DynamicResolutionStats current;
+};
+
+#endif // DYNAMIC_RESOLUTION_HPP_
@@ -0,0 +1,52 @@
+#ifndef FIXED_TIMESTEP_HPP_
+#define FIXED_TIMESTEP_HPP_
+#include <algorithm>
+
+// Accumulator for a fixed-rate simulation. Each frame advance() reports how many
+// ticks of `step` seconds are due; the renderer then blends the last two ticks with alpha().
+// Frames faster than the tick rate run zero ticks, slow frames catch up, but never by more
+// than maxTicks so a long stall (window drag, breakpoint) does not spiral.
+class FixedTimestep {
+public:
+    double step;
+    int maxTicks;
+    int ticksLastFrame;
+
+    FixedTimestep(double stepSeconds = 1.0 / 60.0, int maxTicksPerFrame = 8)
+        : step(stepSeconds), maxTicks(maxTicksPerFrame), ticksLastFrame(0), accumulator(0.0), lastTime(-1.0), firstTick(0.0) {}
+
+    // `now` in seconds, e.g. glfwGetTime()
+    int advance(double now) {
+        if (lastTime < 0.0)
+            lastTime = now;
+        accumulator += now - lastTime;
+        lastTime = now;
+        int ticks = (int)(accumulator / step);
+        if (ticks > maxTicks) {
+            ticks = maxTicks;
+            accumulator = 0.0; // drop the backlog instead of fast-forwarding through it
+        } else {
+            accumulator -= ticks * step;
+        }
+        ticksLastFrame = ticks;
+        firstTick = now - accumulator - ticks * step;
+        return ticks;
+    }
+
+    // Time span covered by tick `tick` (0..ticks-1) of the last advance(), on the clock
+    // passed to advance(); input events are assigned to ticks by these bounds
+    double tickStart(int tick) const { return firstTick + tick * step; }
+    double tickEnd(int tick) const { return firstTick + (tick + 1) * step; }
+
+    // How far the rendered frame is between the previous and the latest tick, 0..1
+    float alpha() const {
+        return (float)std::min(accumulator / step, 1.0);
+    }
+
+private:
+    double accumulator;
+    double lastTime;
+    double firstTick;
+};
+
+#endif // FIXED_TIMESTEP_HPP_
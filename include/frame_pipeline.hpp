@@ -0,0 +1,131 @@
+#ifndef FRAME_PIPELINE_HPP_
+#define FRAME_PIPELINE_HPP_
+#include "./imgui/imgui.h"
+#include "./profiler.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Two-stage frame pipeline: the main thread simulates frame N+1 and fills a snapshot
+// while a render thread, the only thread with the GL context current, submits frame N.
+// Snapshots are double buffered, so the main thread only blocks when it gets two frames
+// ahead and the steady-state frame time is max(simulate, render) instead of their sum.
+template <typename Snapshot>
+class FramePipeline {
+public:
+    FramePipeline() : writeIndex(0), readIndex(0), stop(false) {
+        state[0] = state[1] = SLOT_FREE;
+    }
+
+    ~FramePipeline() {
+        shutdown();
+    }
+
+    // Hands `window`'s context to a new render thread that calls render() for every published snapshot
+    void start(GLFWwindow* window, std::function<void(Snapshot &)> render) {
+        glfwMakeContextCurrent(nullptr);
+        thread = std::thread([this, window, render] {
+            glfwMakeContextCurrent(window);
+            Profiler::instance().setThreadName("Render");
+            renderLoop(render);
+            glfwMakeContextCurrent(nullptr);
+        });
+    }
+
+    // Waits until the render thread is done with the next slot
+    Snapshot &beginFrame() {
+        PROFILE_ZONE("Wait for render thread");
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this] { return state[writeIndex] == SLOT_FREE; });
+        return snapshots[writeIndex];
+    }
+
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            state[writeIndex] = SLOT_READY;
+            writeIndex ^= 1;
+        }
+        changed.notify_all();
+    }
+
+    // Lets the render thread finish what was published, then stops it; the context is
+    // current on no thread afterwards
+    void shutdown() {
+        if (!thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        thread.join();
+    }
+
+private:
+    enum SlotState { SLOT_FREE, SLOT_READY };
+
+    Snapshot snapshots[2];
+    SlotState state[2];
+    int writeIndex, readIndex;
+    bool stop;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread thread;
+
+    void renderLoop(const std::function<void(Snapshot &)> &render) {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [this] { return stop || state[readIndex] == SLOT_READY; });
+                if (state[readIndex] != SLOT_READY)
+                    return;
+            }
+            {
+                PROFILE_ZONE("Render frame");
+                render(snapshots[readIndex]);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                state[readIndex] = SLOT_FREE;
+                readIndex ^= 1;
+            }
+            changed.notify_all();
+        }
+    }
+};
+
+// ImGui draw data copied out of the ImGui context, so the render thread can draw frame N
+// while the main thread already builds the UI of frame N+1
+class UiSnapshot {
+public:
+    ImDrawData drawData;
+
+    UiSnapshot() {}
+    UiSnapshot(const UiSnapshot &) = delete;
+    UiSnapshot &operator=(const UiSnapshot &) = delete;
+
+    ~UiSnapshot() {
+        clear();
+    }
+
+    void capture(const ImDrawData* source) {
+        clear();
+        drawData = *source;
+        drawData.CmdLists.resize(0);
+        for (ImDrawList* list : source->CmdLists)
+            drawData.CmdLists.push_back(list->CloneOutput());
+    }
+
+    void clear() {
+        for (ImDrawList* list : drawData.CmdLists)
+            IM_DELETE(list);
+        drawData.CmdLists.resize(0);
+        drawData.CmdListsCount = 0;
+        drawData.Valid = false;
+    }
+};
+
+#endif // FRAME_PIPELINE_HPP_
@@ -0,0 +1,123 @@
+#ifndef GPU_TIMER_HPP_
+#define GPU_TIMER_HPP_
+#include <vector>
+#include "./profiler.hpp"
+
+// GPU time per render pass from GL_TIMESTAMP query pairs.
+// Queries come from a pool of GPU_TIMER_FRAMES frames; a frame's results are read back
+// when the GPU has reached its last timestamp, typically 2-3 frames later. The CPU never
+// waits: if the oldest frame is still in flight when its queries would be reused, the
+// current frame is just not timed. Resolved frames go to the profiler's GPU lane.
+// GPU timestamps are mapped onto the profiler clock with an offset re-measured every
+// GPU_TIMER_CALIBRATE_FRAMES resolved frames, so traces line up CPU and GPU work.
+// Render thread only.
+
+const int GPU_TIMER_FRAMES = 4;
+const int GPU_TIMER_MAX_SCOPES = 32;
+const int GPU_TIMER_CALIBRATE_FRAMES = 60;
+
+class GpuTimers {
+public:
+    GpuTimers() : frame(0), recording(false), lastFrameMs(0.0f), clockOffset(0), resolvedFrames(0) {
+        for (int f = 0; f < GPU_TIMER_FRAMES; f++) {
+            glGenQueries(GPU_TIMER_MAX_SCOPES * 2, queries[f]);
+            count[f] = 0;
+            pending[f] = false;
+        }
+    }
+
+    // Reads back finished frames; true when a new frame's timings arrived
+    bool beginFrame() {
+        bool resolved = false;
+        for (int i = 1; i <= GPU_TIMER_FRAMES; i++) {
+            int f = (frame + i) % GPU_TIMER_FRAMES; // oldest first
+            if (pending[f] && resolve(f))
+                resolved = true;
+        }
+        frame = (frame + 1) % GPU_TIMER_FRAMES;
+        recording = !pending[frame];
+        if (recording) // a frame still in flight keeps its scopes until resolved
+            count[frame] = 0;
+        return resolved;
+    }
+
+    // Returns the scope index for end(), -1 when this frame is not timed
+    int begin(const ProfileZone* zone) {
+        if (!recording || count[frame] == GPU_TIMER_MAX_SCOPES)
+            return -1;
+        int scope = count[frame]++;
+        zones[frame][scope] = zone;
+        glQueryCounter(queries[frame][scope * 2], GL_TIMESTAMP);
+        return scope;
+    }
+
+    void end(int scope) {
+        if (scope >= 0)
+            glQueryCounter(queries[frame][scope * 2 + 1], GL_TIMESTAMP);
+    }
+
+    void endFrame() {
+        if (recording && count[frame] > 0)
+            pending[frame] = true;
+    }
+
+    // GPU time from the first scope's start to the last scope's end, newest resolved frame
+    float frameMs() const {
+        return lastFrameMs;
+    }
+
+    void destroy() {
+        for (int f = 0; f < GPU_TIMER_FRAMES; f++)
+            glDeleteQueries(GPU_TIMER_MAX_SCOPES * 2, queries[f]);
+    }
+
+private:
+    GLuint queries[GPU_TIMER_FRAMES][GPU_TIMER_MAX_SCOPES * 2];
+    const ProfileZone* zones[GPU_TIMER_FRAMES][GPU_TIMER_MAX_SCOPES];
+    int count[GPU_TIMER_FRAMES];
+    bool pending[GPU_TIMER_FRAMES];
+    int frame;
+    bool recording;
+    float lastFrameMs;
+    int64_t clockOffset; // profileNow() - GL_TIMESTAMP
+    int resolvedFrames;
+
+    void calibrate() {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        clockOffset = profileNow() - gpuNow;
+    }
+
+    bool resolve(int f) {
+        if (count[f] == 0) {
+            pending[f] = false;
+            return false;
+        }
+        // Timestamps complete in order, so the last one being there means all are
+        GLint available = 0;
+        glGetQueryObjectiv(queries[f][count[f] * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return false;
+
+        if (resolvedFrames++ % GPU_TIMER_CALIBRATE_FRAMES == 0)
+            calibrate();
+        std::vector<GpuScopeTiming> timings(count[f]);
+        GLuint64 origin = 0;
+        for (int scope = 0; scope < count[f]; scope++) {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(queries[f][scope * 2], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(queries[f][scope * 2 + 1], GL_QUERY_RESULT, &end);
+            if (scope == 0)
+                origin = begin;
+            timings[scope] = { zones[f][scope], (float)((begin - origin) / 1.0e6), (float)((end - origin) / 1.0e6),
+                               (int64_t)begin + clockOffset, (int64_t)end + clockOffset };
+        }
+        pending[f] = false;
+        lastFrameMs = timings.back().endMs;
+
+        Profiler::instance().submitGpuFrame(timings);
+        return true;
+    }
+};
+
+#endif // GPU_TIMER_HPP_
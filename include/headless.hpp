@@ -0,0 +1,40 @@
+#ifndef HEADLESS_HPP_
+#define HEADLESS_HPP_
+
+// GL context without a display, for benchmarks and CI: GLFW 3.4's null platform with a
+// surfaceless EGL context (Mesa, llvmpipe included), OSMesa when EGL is not there.
+// There is no window surface to draw to or swap, render into a framebuffer object.
+
+// Before glfwInit()
+inline void headlessPlatformHint() {
+#ifdef GLFW_PLATFORM_NULL
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+    std::cerr << "ERROR::HEADLESS::NEEDS_GLFW_3_4" << std::endl;
+#endif
+}
+
+// Context hints (version, profile) are the caller's
+inline GLFWwindow* createHeadlessWindow(int width, int height, const char* title) {
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    GLFWwindow* window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    if (!window) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+        window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+    }
+    return window;
+}
+
+// glewInit() for a headless context: GLEW built for GLX still loads the GL entry points
+// on an EGL context, it only fails to find a GLX display afterwards
+inline GLenum headlessGlewInit() {
+    glewExperimental = GL_TRUE;
+    GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (status == GLEW_ERROR_NO_GLX_DISPLAY)
+        status = GLEW_OK;
+#endif
+    return status;
+}
+
+#endif // HEADLESS_HPP_
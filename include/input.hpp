@@ -0,0 +1,202 @@
+#ifndef INPUT_HPP_
+#define INPUT_HPP_
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Timestamped input.
+// GLFW callbacks only push events into a lock-free ring; the fixed-step simulation pulls
+// them and applies each one in the tick its timestamp falls into, so key hold times are
+// exact to the event, not rounded to whole frames or ticks. No keys are polled: with no
+// events nothing runs. The same event stream always produces the same simulation, which
+// is what replay builds on.
+
+enum InputEventType : uint8_t { INPUT_KEY, INPUT_MOUSE_BUTTON, INPUT_MOUSE_MOVE, INPUT_SCROLL };
+
+struct InputEvent {
+    double time;  // glfwGetTime() seconds
+    InputEventType type;
+    int code;     // key or mouse button
+    int action;   // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+    float x, y;   // mouse delta (y up) or scroll offset
+};
+
+// Single producer, single consumer ring; capacity must be a power of two
+template <typename T, unsigned int Capacity>
+class SpscQueue {
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    bool push(const T &value) {
+        unsigned int t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        unsigned int h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        value = items[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    std::atomic<unsigned int> head, tail;
+};
+
+// What one simulation tick sees: the events inside [start, end) in order, and how long
+// each key was held within the tick
+struct TickInput {
+    double start, end;
+    std::vector<InputEvent> events;
+
+    float heldSeconds(int key) const;
+
+private:
+    friend class InputSystem;
+    const class InputSystem* system;
+};
+
+class InputSystem {
+public:
+    int droppedEvents; // ring overflow, should stay 0
+    std::atomic<bool> live; // GLFW events reach the simulation; off while replaying a recording
+
+    InputSystem() : droppedEvents(0), live(true), resetCursor(true), lastX(0.0), lastY(0.0) {
+        std::fill(pressedAt, pressedAt + KEY_COUNT, -1.0);
+        std::fill(heldThisTick, heldThisTick + KEY_COUNT, 0.0f);
+    }
+
+    // Must run before ImGui_ImplGlfw_InitForOpenGL so ImGui chains to these callbacks
+    void install(GLFWwindow* window) {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, [](GLFWwindow* w, int key, int, int action, int) {
+            if (key >= 0 && key < KEY_COUNT)
+                get(w)->recordLive({ glfwGetTime(), INPUT_KEY, key, action, 0.0f, 0.0f });
+        });
+        glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int button, int action, int) {
+            get(w)->recordLive({ glfwGetTime(), INPUT_MOUSE_BUTTON, button, action, 0.0f, 0.0f });
+        });
+        glfwSetCursorPosCallback(window, [](GLFWwindow* w, double x, double y) {
+            InputSystem* input = get(w);
+            if (input->resetCursor.exchange(false)) {
+                input->lastX = x;
+                input->lastY = y;
+                return;
+            }
+            // Reversed y since window coordinates go from top to bottom
+            input->recordLive({ glfwGetTime(), INPUT_MOUSE_MOVE, 0, 0, (float)(x - input->lastX), (float)(input->lastY - y) });
+            input->lastX = x;
+            input->lastY = y;
+        });
+        glfwSetScrollCallback(window, [](GLFWwindow* w, double x, double y) {
+            get(w)->recordLive({ glfwGetTime(), INPUT_SCROLL, 0, 0, (float)x, (float)y });
+        });
+    }
+
+    // Hides the cursor and, where supported, switches to unaccelerated raw motion
+    void setMouseCaptured(GLFWwindow* window, bool captured, bool raw) {
+        glfwSetInputMode(window, GLFW_CURSOR, captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+        if (glfwRawMouseMotionSupported())
+            glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, captured && raw ? GLFW_TRUE : GLFW_FALSE);
+        resetCursor = true; // the cursor jumps when the mode changes
+    }
+
+    // Hands the simulation every event up to `end`; later events wait for the next tick
+    void tick(double start, double end, TickInput &out) {
+        drain();
+
+        for (int key : touchedKeys)
+            heldThisTick[key] = 0.0f;
+        touchedKeys.clear();
+
+        out.start = start;
+        out.end = end;
+        out.events.clear();
+        out.system = this;
+        size_t used = 0;
+        for (; used < pending.size() && pending[used].time < end; used++) {
+            const InputEvent &event = pending[used];
+            out.events.push_back(event);
+            if (event.type != INPUT_KEY || event.action == GLFW_REPEAT)
+                continue;
+            int key = event.code;
+            double t = std::max(event.time, start);
+            if (event.action == GLFW_PRESS && pressedAt[key] < 0.0) {
+                pressedAt[key] = t;
+            } else if (event.action == GLFW_RELEASE && pressedAt[key] >= 0.0) {
+                heldThisTick[key] += (float)(t - std::max(pressedAt[key], start));
+                pressedAt[key] = -1.0;
+                touchedKeys.push_back(key);
+            }
+        }
+        pending.erase(pending.begin(), pending.begin() + used);
+    }
+
+    // Mouse motion that arrived after the last simulated tick, for late-latching the camera.
+    // Only looks at the events; the simulation still applies them in their own ticks.
+    void pendingMouseMotion(float &dx, float &dy) {
+        drain();
+        dx = dy = 0.0f;
+        for (const InputEvent &event : pending) {
+            if (event.type != INPUT_MOUSE_MOVE)
+                continue;
+            dx += event.x;
+            dy += event.y;
+        }
+    }
+
+    bool keyDown(int key) const { return pressedAt[key] >= 0.0; }
+
+    float heldSeconds(int key, double start, double end) const {
+        float held = heldThisTick[key];
+        if (pressedAt[key] >= 0.0)
+            held += (float)(end - std::max(pressedAt[key], start));
+        return held;
+    }
+
+    // Feeds an event as if it came from GLFW (replay, tests)
+    void record(const InputEvent &event) {
+        if (!queue.push(event))
+            droppedEvents++;
+    }
+
+private:
+    static const int KEY_COUNT = GLFW_KEY_LAST + 1;
+
+    SpscQueue<InputEvent, 1024> queue;
+    std::vector<InputEvent> pending; // pulled from the ring, not simulated yet
+    double pressedAt[KEY_COUNT];     // -1 while up
+    float heldThisTick[KEY_COUNT];   // time held by keys released during the current tick
+    std::vector<int> touchedKeys;
+    std::atomic<bool> resetCursor;
+    double lastX, lastY;             // producer side only
+
+    void recordLive(const InputEvent &event) {
+        if (live)
+            record(event);
+    }
+
+    void drain() {
+        InputEvent event;
+        while (queue.pop(event))
+            pending.push_back(event);
+    }
+
+    static InputSystem* get(GLFWwindow* window) {
+        return static_cast<InputSystem*>(glfwGetWindowUserPointer(window));
+    }
+};
+
+inline float TickInput::heldSeconds(int key) const {
+    return system->heldSeconds(key, start, end);
+}
+
+#endif // INPUT_HPP_
@@ -0,0 +1,211 @@
+#ifndef INPUT_RECORDING_HPP_
+#define INPUT_RECORDING_HPP_
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "./input.hpp"
+
+// Input recording and replay (--record <file>, --replay <file>).
+// A recording is the scene the session started from, then one entry per frame: the clock
+// value the fixed-step simulation advanced to, the input events its ticks consumed, the
+// UI changes made that frame and what else the simulation read from outside (animation
+// delta time, whether the mouse was over the UI). Replay feeds exactly these back, so the
+// simulation runs the same ticks on the same doubles and ends in the same state, windowed
+// or under --benchmark, at any frame rate; only rendering and its timings differ.
+// Binary in native byte order: 18 bytes per frame, 20 per event, 5 per UI change.
+
+// Settings changed from the UI that the simulation or the scene depends on
+enum UiActionType : uint8_t { UI_TIME_OF_DAY, UI_LAMP, UI_CRATER, UI_WALL, UI_WOLF_PACK, UI_ANIMATION_LOD };
+
+struct UiAction {
+    UiActionType type;
+    float value; // slider value, or 0/1
+};
+
+// What a recording starts from; the terrain itself is generated the same every run
+struct RecordedScene {
+    glm::vec3 cameraPosition;
+    float cameraYaw, cameraPitch, cameraZoom;
+    float timeOfDay, timeSpeed;
+    bool lampPlaced, showWolfPack, animationLod;
+};
+
+struct RecordedFrame {
+    double clock;                   // passed to FixedTimestep::advance
+    float animationDelta;           // seconds, passed to AnimationRuntime::update
+    bool uiWantsMouse;              // clicks and scrolling went to the UI
+    std::vector<InputEvent> events; // in the order the ticks consumed them
+    std::vector<UiAction> actions;
+
+    void clear() {
+        events.clear();
+        actions.clear();
+    }
+};
+
+const uint32_t INPUT_RECORDING_MAGIC = 0x5250494a; // "JIPR"
+const uint32_t INPUT_RECORDING_VERSION = 1;
+
+// Streams frames to the file as they are simulated
+class InputRecorder {
+public:
+    bool active() const { return file.is_open(); }
+    int frames() const { return frameCount; }
+
+    bool start(const std::string &path, double step, const RecordedScene &scene) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "ERROR::INPUT_RECORDING::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        frameCount = 0;
+        put(INPUT_RECORDING_MAGIC);
+        put(INPUT_RECORDING_VERSION);
+        put(step);
+        put(scene.cameraPosition.x);
+        put(scene.cameraPosition.y);
+        put(scene.cameraPosition.z);
+        put(scene.cameraYaw);
+        put(scene.cameraPitch);
+        put(scene.cameraZoom);
+        put(scene.timeOfDay);
+        put(scene.timeSpeed);
+        put((uint8_t)(scene.lampPlaced | scene.showWolfPack << 1 | scene.animationLod << 2));
+        return true;
+    }
+
+    void write(const RecordedFrame &frame) {
+        if (!active())
+            return;
+        put(frame.clock);
+        put(frame.animationDelta);
+        put((uint8_t)frame.uiWantsMouse);
+        put((uint32_t)frame.events.size());
+        put((uint8_t)frame.actions.size());
+        for (const InputEvent &event : frame.events) {
+            put(event.time);
+            put((uint8_t)event.type);
+            put((int16_t)event.code);
+            put((int8_t)event.action);
+            put(event.x);
+            put(event.y);
+        }
+        for (const UiAction &action : frame.actions) {
+            put((uint8_t)action.type);
+            put(action.value);
+        }
+        frameCount++;
+    }
+
+    void stop() {
+        if (!active())
+            return;
+        file.close();
+        std::cout << "Input recorded: " << frameCount << " frames" << std::endl;
+    }
+
+private:
+    std::ofstream file;
+    int frameCount = 0;
+
+    template <typename T>
+    void put(const T &value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+};
+
+// A whole recording in memory, handed out one frame at a time
+class InputReplay {
+public:
+    double step = 0.0;
+    RecordedScene scene;
+    std::vector<RecordedFrame> frames;
+
+    bool loaded() const { return !frames.empty(); }
+    int position() const { return cursor; }
+
+    // Next frame to simulate, nullptr at the end
+    const RecordedFrame* next() {
+        return cursor < (int)frames.size() ? &frames[cursor++] : nullptr;
+    }
+
+    bool load(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "ERROR::INPUT_REPLAY::CANNOT_READ " << path << std::endl;
+            return false;
+        }
+        uint32_t magic = 0, version = 0;
+        get(file, magic);
+        get(file, version);
+        if (magic != INPUT_RECORDING_MAGIC || version != INPUT_RECORDING_VERSION) {
+            std::cerr << "ERROR::INPUT_REPLAY::NOT_A_RECORDING " << path << std::endl;
+            return false;
+        }
+        uint8_t flags = 0;
+        get(file, step);
+        get(file, scene.cameraPosition.x);
+        get(file, scene.cameraPosition.y);
+        get(file, scene.cameraPosition.z);
+        get(file, scene.cameraYaw);
+        get(file, scene.cameraPitch);
+        get(file, scene.cameraZoom);
+        get(file, scene.timeOfDay);
+        get(file, scene.timeSpeed);
+        get(file, flags);
+        scene.lampPlaced = flags & 1;
+        scene.showWolfPack = flags & 2;
+        scene.animationLod = flags & 4;
+
+        std::vector<RecordedFrame> loadedFrames;
+        RecordedFrame frame;
+        uint8_t uiWantsMouse, actionCount;
+        uint32_t eventCount;
+        // A session that did not exit cleanly ends in a partial frame, which is dropped
+        while (get(file, frame.clock) && get(file, frame.animationDelta) && get(file, uiWantsMouse) &&
+               get(file, eventCount) && get(file, actionCount)) {
+            frame.uiWantsMouse = uiWantsMouse != 0;
+            frame.events.resize(eventCount);
+            frame.actions.resize(actionCount);
+            bool complete = true;
+            for (InputEvent &event : frame.events) {
+                uint8_t type;
+                int16_t code;
+                int8_t action;
+                complete = complete && get(file, event.time) && get(file, type) && get(file, code) && get(file, action) &&
+                           get(file, event.x) && get(file, event.y);
+                event.type = (InputEventType)type;
+                event.code = code;
+                event.action = action;
+            }
+            for (UiAction &action : frame.actions) {
+                uint8_t type;
+                complete = complete && get(file, type) && get(file, action.value);
+                action.type = (UiActionType)type;
+            }
+            if (!complete)
+                break;
+            loadedFrames.push_back(frame);
+        }
+        if (loadedFrames.empty()) {
+            std::cerr << "ERROR::INPUT_REPLAY::NO_FRAMES " << path << std::endl;
+            return false;
+        }
+        frames.swap(loadedFrames);
+        cursor = 0;
+        return true;
+    }
+
+private:
+    int cursor = 0;
+
+    template <typename T>
+    static bool get(std::ifstream &file, T &value) {
+        return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+};
+
+#endif // INPUT_RECORDING_HPP_
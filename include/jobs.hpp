@@ -0,0 +1,209 @@
+#ifndef JOBS_HPP_
+#define JOBS_HPP_
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "./profiler.hpp"
+
+// Work-stealing job system.
+//  - one deque per thread: the owner pushes and pops at the back (LIFO, cache-warm),
+//    idle threads steal from the front of someone else's deque
+//  - a job finishes once its function and all of its children have run, so waiting on
+//    a parent waits on the whole tree; waiting threads keep executing jobs meanwhile
+//  - jobs come from a per-thread ring, JOB_POOL_SIZE jobs can be in flight per thread
+//  - GL calls are only legal on the thread that owns the context: jobs hand them over with
+//    runOnGLThread() and that thread executes them in drainGLThread()
+// Jobs may only be created from the main thread (worker 0) or from inside other jobs.
+
+const int JOB_POOL_SIZE = 4096; // power of two
+
+struct Job {
+    std::function<void()> fn;
+    Job* parent;
+    std::atomic<int> unfinished; // itself plus unfinished children
+};
+
+class JobSystem {
+public:
+    JobSystem(unsigned int threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1)
+        : queued(0), stop(false) {
+        workers.resize(threadCount + 1);
+        for (auto &worker : workers)
+            worker.reset(new Worker());
+        workerIndex() = 0;
+        for (unsigned int i = 1; i <= threadCount; i++)
+            threads.emplace_back([this, i] { workerLoop((int)i); });
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    int workerCount() const { return (int)workers.size(); }
+
+    // Child jobs must be created before the parent is run
+    Job* create(std::function<void()> fn, Job* parent = nullptr) {
+        Worker &worker = *workers[workerIndex()];
+        Job* job = &worker.pool[worker.allocated++ & (JOB_POOL_SIZE - 1)];
+        job->fn = std::move(fn);
+        job->parent = parent;
+        job->unfinished = 1;
+        if (parent)
+            parent->unfinished++;
+        return job;
+    }
+
+    void run(Job* job) {
+        Worker &worker = *workers[workerIndex()];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.queue.push_back(job);
+            queued++;
+        }
+        // Sleepers check `queued` under sleepMutex, taking it here closes the lost wakeup window
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        wake.notify_one();
+    }
+
+    // Helps with other jobs until `job` and its children are done
+    void wait(const Job* job) {
+        while (job->unfinished.load() > 0) {
+            Job* next = getJob(workerIndex());
+            if (next)
+                execute(next);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    // fn(begin, end) over [0, count) in chunks of `grain`; returns when every chunk is done
+    void parallel_for(int count, int grain, const std::function<void(int, int)> &fn) {
+        if (count <= 0)
+            return;
+        grain = std::max(grain, 1);
+        if (count <= grain) {
+            fn(0, count);
+            return;
+        }
+        Job* root = create(nullptr);
+        for (int begin = 0; begin < count; begin += grain) {
+            int end = std::min(begin + grain, count);
+            run(create([&fn, begin, end] { fn(begin, end); }, root));
+        }
+        run(root);
+        wait(root);
+    }
+
+    // Queues GL work (uploads, deletes) for the thread that owns the context
+    void runOnGLThread(std::function<void()> fn) {
+        std::lock_guard<std::mutex> lock(glMutex);
+        glQueue.push_back(std::move(fn));
+    }
+
+    // GL thread only, once per frame
+    void drainGLThread() {
+        std::vector<std::function<void()>> pending;
+        {
+            std::lock_guard<std::mutex> lock(glMutex);
+            pending.swap(glQueue);
+        }
+        for (auto &fn : pending)
+            fn();
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job*> queue;
+        std::vector<Job> pool;
+        unsigned int allocated;
+
+        Worker() : pool(JOB_POOL_SIZE), allocated(0) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<int> queued; // jobs sitting in any deque
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stop;
+    std::mutex glMutex;
+    std::vector<std::function<void()>> glQueue;
+
+    static int &workerIndex() {
+        static thread_local int index = 0;
+        return index;
+    }
+
+    Job* getJob(int self) {
+        {
+            Worker &worker = *workers[self];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.queue.empty()) {
+                Job* job = worker.queue.back();
+                worker.queue.pop_back();
+                queued--;
+                return job;
+            }
+        }
+        // Steal, starting after ourselves so victims are spread out
+        int count = (int)workers.size();
+        for (int k = 1; k < count; k++) {
+            Worker &victim = *workers[(self + k) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queue.empty()) {
+                Job* job = victim.queue.front();
+                victim.queue.pop_front();
+                queued--;
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    void execute(Job* job) {
+        PROFILE_ZONE("Job");
+        if (job->fn)
+            job->fn();
+        finish(job);
+    }
+
+    void finish(Job* job) {
+        while (job) {
+            Job* parent = job->parent;
+            if (--job->unfinished > 0)
+                return;
+            job = parent;
+        }
+    }
+
+    void workerLoop(int index) {
+        workerIndex() = index;
+        Profiler::instance().setThreadName("Worker " + std::to_string(index));
+        while (true) {
+            Job* job = getJob(index);
+            if (job) {
+                execute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stop || queued.load() > 0; });
+            if (stop)
+                return;
+        }
+    }
+};
+
+#endif // JOBS_HPP_
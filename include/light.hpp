@@ -0,0 +1,191 @@
+#ifndef LIGHT_HPP_
+#define LIGHT_HPP_
+#include "./chunk.hpp"
+#include <chrono>
+
+// Incremental BFS flood fill for sky and block light.
+// Edits only push the affected voxels into the add/remove queues, so the
+// work is proportional to the changed light volume, never a whole chunk.
+class LightEngine {
+public:
+    World &world;
+    float lastUpdateMs; // time spent in the last propagate() call
+
+    LightEngine(World &w) : world(w), lastUpdateMs(0.0f) {}
+
+    // Full lighting pass for freshly generated terrain (startup only)
+    void lightWorld() {
+        int sx = world.size.x * CHUNK_SIZE;
+        int sz = world.size.z * CHUNK_SIZE;
+        int top = world.heightInBlocks() - 1;
+        for (int x = 0; x < sx; x++) {
+            for (int z = 0; z < sz; z++) {
+                for (int y = top; y >= 0; y--) {
+                    glm::ivec3 p(x, y, z);
+                    if (isOpaque(world.getBlock(p)))
+                        break;
+                    setLight(p, true, MAX_LIGHT);
+                    skyAdd.push_back(p);
+                }
+            }
+        }
+        for (Chunk &chunk : world.chunks) {
+            for (int i = 0; i < CHUNK_VOLUME; i++) {
+                uint8_t emission = blockEmission(chunk.blocks.get(i));
+                if (emission == 0)
+                    continue;
+                chunk.setBlockLight(i, emission);
+                int x = i % CHUNK_SIZE, z = (i / CHUNK_SIZE) % CHUNK_SIZE, y = i / (CHUNK_SIZE * CHUNK_SIZE);
+                blockAdd.push_back(chunk.coord * CHUNK_SIZE + glm::ivec3(x, y, z));
+            }
+        }
+        propagate();
+    }
+
+    // Changes a block and queues the light update. Call propagate() once after a batch of edits
+    // (WorldEditor::flush does this once per frame).
+    void setBlock(glm::ivec3 p, uint16_t block) {
+        int i;
+        Chunk* chunk = world.locate(p, i);
+        if (!chunk)
+            return;
+        uint16_t old = chunk->blocks.get(i);
+        if (old == block)
+            return;
+        chunk->blocks.set(i, block);
+        onBlockChanged(p, old, block);
+    }
+
+    // Queues the light changes for a block that was already written to storage
+    void onBlockChanged(glm::ivec3 p, uint16_t old, uint16_t block) {
+        world.markDirty(p);
+
+        uint8_t sky = world.getSkyLight(p);
+        uint8_t blockLight = world.getBlockLight(p);
+
+        // Whatever light this voxel carried (or emitted) has to be withdrawn first
+        if (blockLight > 0 && (isOpaque(block) || blockEmission(old) > 0)) {
+            setLight(p, false, 0);
+            blockRemove.push_back({ p, blockLight });
+        }
+        if (sky > 0 && isOpaque(block)) {
+            setLight(p, true, 0);
+            skyRemove.push_back({ p, sky });
+        }
+
+        if (blockEmission(block) > 0) {
+            setLight(p, false, blockEmission(block));
+            blockAdd.push_back(p);
+        }
+
+        // A voxel that became transparent gets refilled from its neighbours
+        if (isOpaque(old) && !isOpaque(block)) {
+            for (const glm::ivec3 &d : directions) {
+                glm::ivec3 n = p + d;
+                if (!world.inBounds(n)) {
+                    // Open sky above the world
+                    if (d.y == 1) {
+                        setLight(p, true, MAX_LIGHT);
+                        skyAdd.push_back(p);
+                    }
+                    continue;
+                }
+                if (world.getSkyLight(n) > 0)
+                    skyAdd.push_back(n);
+                if (world.getBlockLight(n) > 0)
+                    blockAdd.push_back(n);
+            }
+        }
+    }
+
+    void propagate() {
+        auto start = std::chrono::steady_clock::now();
+        propagateRemove(blockRemove, blockAdd, false);
+        propagateRemove(skyRemove, skyAdd, true);
+        propagateAdd(blockAdd, false);
+        propagateAdd(skyAdd, true);
+        lastUpdateMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    struct RemoveNode {
+        glm::ivec3 pos;
+        uint8_t level;
+    };
+
+    // Queues are plain vectors consumed front to back and reused between updates
+    std::vector<glm::ivec3> blockAdd, skyAdd;
+    std::vector<RemoveNode> blockRemove, skyRemove;
+
+    const glm::ivec3 directions[6] = {
+        glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0),
+        glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0),
+        glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1)
+    };
+
+    uint8_t getLight(glm::ivec3 p, bool sky) {
+        return sky ? world.getSkyLight(p) : world.getBlockLight(p);
+    }
+
+    void setLight(glm::ivec3 p, bool sky, uint8_t level) {
+        int i;
+        Chunk* chunk = world.locate(p, i);
+        if (!chunk)
+            return;
+        if (sky)
+            chunk->setSkyLight(i, level);
+        else
+            chunk->setBlockLight(i, level);
+        world.markDirty(p);
+    }
+
+    void propagateRemove(std::vector<RemoveNode> &queue, std::vector<glm::ivec3> &refill, bool sky) {
+        for (size_t head = 0; head < queue.size(); head++) {
+            RemoveNode node = queue[head];
+            for (const glm::ivec3 &d : directions) {
+                glm::ivec3 n = node.pos + d;
+                if (!world.inBounds(n))
+                    continue;
+                uint8_t level = getLight(n, sky);
+                if (level == 0)
+                    continue;
+                // Full-strength sky light falls straight down without attenuation
+                bool skyColumn = sky && d.y == -1 && node.level == MAX_LIGHT;
+                if (level < node.level || skyColumn) {
+                    // Emitters keep their own light, they just need to re-spread it
+                    uint8_t emission = sky ? 0 : blockEmission(world.getBlock(n));
+                    setLight(n, sky, emission);
+                    queue.push_back({ n, level });
+                    if (emission > 0)
+                        refill.push_back(n);
+                } else {
+                    // Lit from another source, flood back into the cleared area
+                    refill.push_back(n);
+                }
+            }
+        }
+        queue.clear();
+    }
+
+    void propagateAdd(std::vector<glm::ivec3> &queue, bool sky) {
+        for (size_t head = 0; head < queue.size(); head++) {
+            glm::ivec3 p = queue[head];
+            uint8_t level = getLight(p, sky);
+            if (level <= 1)
+                continue;
+            for (const glm::ivec3 &d : directions) {
+                glm::ivec3 n = p + d;
+                if (!world.inBounds(n) || isOpaque(world.getBlock(n)))
+                    continue;
+                uint8_t next = (sky && d.y == -1 && level == MAX_LIGHT) ? MAX_LIGHT : level - 1;
+                if (getLight(n, sky) < next) {
+                    setLight(n, sky, next);
+                    queue.push_back(n);
+                }
+            }
+        }
+        queue.clear();
+    }
+};
+
+#endif // LIGHT_HPP_
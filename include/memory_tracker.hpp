@@ -0,0 +1,292 @@
+#ifndef MEMORY_TRACKER_HPP_
+#define MEMORY_TRACKER_HPP_
+#include "./imgui/imgui.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+// Memory per subsystem, CPU and GPU, current and peak.
+// CPU: every allocation carries a small header with its size and tag. The tag comes from
+// the innermost MemoryScope on the allocating thread (MEM_GENERAL outside any), so
+// libraries are covered without touching them: Assimp through the global operator new,
+// stb_image through STBI_MALLOC, ImGui through its allocator functions.
+// The operators are replaced where MEMORY_TRACKER_IMPLEMENTATION is defined (main.cpp).
+// GPU: estimates recorded where buffers and textures are specified, by GL name, so
+// re-specifying one replaces its old size; destroy() paths release them.
+
+enum MemoryTag {
+    MEM_GENERAL,
+    MEM_ASSIMP,     // importer scenes, freed after loading
+    MEM_MESHES,     // vertex and index copies kept by Mesh, skeletons, clips
+    MEM_IMAGES,     // decoded pixels, textures
+    MEM_WORLD,      // voxels, light, chunk meshes
+    MEM_ANIMATION,  // runtime poses, bone palettes, baked clips
+    MEM_RENDERER,   // render targets, uniform buffers
+    MEM_IMGUI,
+    MEM_PROFILER,
+    MEM_TAG_COUNT
+};
+
+inline const char* memoryTagName(int tag) {
+    static const char* names[MEM_TAG_COUNT] = { "General", "Assimp", "Meshes", "Images", "World", "Animation", "Renderer", "ImGui", "Profiler" };
+    return tag >= 0 && tag < MEM_TAG_COUNT ? names[tag] : "?";
+}
+
+enum GpuResourceKind { GPU_BUFFER, GPU_TEXTURE, GPU_RENDERBUFFER };
+
+const unsigned long long MEMORY_BUDGET_BYTES = 4ULL << 30; // smallest client machine
+
+struct MemoryUsage {
+    long long current, peak, allocations;
+};
+
+struct MemoryStats {
+    MemoryUsage cpu[MEM_TAG_COUNT];
+    MemoryUsage gpu[MEM_TAG_COUNT]; // allocations: live resources
+    long long cpuTotal, cpuPeak, gpuTotal, gpuPeak;
+};
+
+class MemoryTracker {
+public:
+    // Never destroyed: frees keep arriving from static destructors
+    static MemoryTracker &instance() {
+        alignas(MemoryTracker) static unsigned char storage[sizeof(MemoryTracker)];
+        static MemoryTracker* tracker = new (storage) MemoryTracker();
+        return *tracker;
+    }
+
+    // CPU, any thread, lock-free
+    void allocated(int tag, size_t bytes) {
+        cpu[tag].allocations.fetch_add(1, std::memory_order_relaxed);
+        add(cpu[tag], (long long)bytes);
+        add(cpuTotal, (long long)bytes);
+    }
+
+    void freed(int tag, size_t bytes) {
+        cpu[tag].current.fetch_sub((long long)bytes, std::memory_order_relaxed);
+        cpuTotal.current.fetch_sub((long long)bytes, std::memory_order_relaxed);
+    }
+
+    // GPU, any thread; bytes is the new size of the resource
+    void gpuAllocated(int tag, GpuResourceKind kind, GLuint name, size_t bytes) {
+        std::lock_guard<std::mutex> lock(gpuMutex);
+        GpuResource &resource = gpuResources[key(kind, name)];
+        if (resource.bytes > 0)
+            release(resource);
+        gpu[tag].allocations++;
+        resource.tag = tag;
+        resource.bytes = (long long)bytes;
+        add(gpu[tag], resource.bytes);
+        add(gpuTotal, resource.bytes);
+    }
+
+    void gpuFreed(GpuResourceKind kind, GLuint name) {
+        std::lock_guard<std::mutex> lock(gpuMutex);
+        auto found = gpuResources.find(key(kind, name));
+        if (found == gpuResources.end())
+            return;
+        release(found->second);
+        gpuResources.erase(found);
+    }
+
+    MemoryStats stats() {
+        MemoryStats stats;
+        for (int tag = 0; tag < MEM_TAG_COUNT; tag++)
+            stats.cpu[tag] = { cpu[tag].current.load(), cpu[tag].peak.load(), cpu[tag].allocations.load() };
+        stats.cpuTotal = cpuTotal.current.load();
+        stats.cpuPeak = cpuTotal.peak.load();
+        std::lock_guard<std::mutex> lock(gpuMutex);
+        for (int tag = 0; tag < MEM_TAG_COUNT; tag++)
+            stats.gpu[tag] = { gpu[tag].current.load(), gpu[tag].peak.load(), gpu[tag].allocations.load() };
+        stats.gpuTotal = gpuTotal.current.load();
+        stats.gpuPeak = gpuTotal.peak.load();
+        return stats;
+    }
+
+private:
+    struct Counter {
+        std::atomic<long long> current{ 0 };
+        std::atomic<long long> peak{ 0 };
+        std::atomic<long long> allocations{ 0 }; // CPU: made so far, GPU: live
+    };
+
+    struct GpuResource {
+        int tag = MEM_GENERAL;
+        long long bytes = 0;
+    };
+
+    Counter cpu[MEM_TAG_COUNT];
+    Counter cpuTotal;
+    Counter gpu[MEM_TAG_COUNT];
+    Counter gpuTotal;
+    std::mutex gpuMutex;
+    std::unordered_map<uint64_t, GpuResource> gpuResources;
+
+    MemoryTracker() {}
+
+    static uint64_t key(GpuResourceKind kind, GLuint name) {
+        return ((uint64_t)kind << 32) | name;
+    }
+
+    static void add(Counter &counter, long long bytes) {
+        long long now = counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        long long peak = counter.peak.load(std::memory_order_relaxed);
+        while (now > peak && !counter.peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    }
+
+    void release(const GpuResource &resource) {
+        gpu[resource.tag].allocations--;
+        gpu[resource.tag].current -= resource.bytes;
+        gpuTotal.current -= resource.bytes;
+    }
+};
+
+// Thread's current tag
+inline int &currentMemoryTag() {
+    static thread_local int tag = MEM_GENERAL;
+    return tag;
+}
+
+// Tags the allocations of the rest of the enclosing scope on this thread
+class MemoryScope {
+public:
+    explicit MemoryScope(int tag) : previous(currentMemoryTag()) {
+        currentMemoryTag() = tag;
+    }
+    ~MemoryScope() {
+        currentMemoryTag() = previous;
+    }
+    MemoryScope(const MemoryScope &) = delete;
+    MemoryScope &operator=(const MemoryScope &) = delete;
+
+private:
+    int previous;
+};
+
+// Header in front of every tracked block; 16 bytes keeps malloc's alignment
+struct alignas(16) MemoryHeader {
+    uint64_t size;
+    uint32_t tag;
+};
+
+inline void* memoryAllocate(size_t size, int tag) {
+    MemoryHeader* header = (MemoryHeader*)std::malloc(sizeof(MemoryHeader) + size);
+    if (!header)
+        return nullptr;
+    header->size = size;
+    header->tag = (uint32_t)tag;
+    MemoryTracker::instance().allocated(tag, size);
+    return header + 1;
+}
+
+inline void memoryFree(void* pointer) {
+    if (!pointer)
+        return;
+    MemoryHeader* header = (MemoryHeader*)pointer - 1;
+    MemoryTracker::instance().freed((int)header->tag, (size_t)header->size);
+    std::free(header);
+}
+
+inline void* memoryReallocate(void* pointer, size_t size, int tag) {
+    if (!pointer)
+        return memoryAllocate(size, tag);
+    MemoryHeader* header = (MemoryHeader*)pointer - 1;
+    int oldTag = (int)header->tag;
+    size_t oldSize = (size_t)header->size;
+    MemoryHeader* moved = (MemoryHeader*)std::realloc(header, sizeof(MemoryHeader) + size);
+    if (!moved)
+        return nullptr;
+    MemoryTracker::instance().freed(oldTag, oldSize);
+    moved->size = size;
+    moved->tag = (uint32_t)tag;
+    MemoryTracker::instance().allocated(tag, size);
+    return moved + 1;
+}
+
+inline void* imguiAllocate(size_t size, void*) {
+    return memoryAllocate(size, MEM_IMGUI);
+}
+
+inline void imguiFree(void* pointer, void*) {
+    memoryFree(pointer);
+}
+
+// Current and peak per tag against the budget
+class MemoryPanel {
+public:
+    void draw() {
+        MemoryStats stats = MemoryTracker::instance().stats();
+        ImGui::Begin("Memory");
+        long long total = stats.cpuTotal + stats.gpuTotal;
+        char overlay[64];
+        std::snprintf(overlay, sizeof(overlay), "%.0f / %.0f MB", total / 1048576.0, MEMORY_BUDGET_BYTES / 1048576.0);
+        ImGui::ProgressBar((float)((double)total / MEMORY_BUDGET_BYTES), ImVec2(-1.0f, 0.0f), overlay);
+        if (ImGui::BeginTable("memory", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            const char* columns[6] = { "Subsystem", "CPU MB", "CPU peak", "Allocations", "GPU MB (est.)", "GPU peak" };
+            for (const char* column : columns)
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+            for (int tag = 0; tag < MEM_TAG_COUNT; tag++)
+                row(memoryTagName(tag), stats.cpu[tag], stats.gpu[tag]);
+            row("Total", { stats.cpuTotal, stats.cpuPeak, 0 }, { stats.gpuTotal, stats.gpuPeak, 0 });
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+private:
+    static void row(const char* name, const MemoryUsage &cpu, const MemoryUsage &gpu) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", cpu.current / 1048576.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", cpu.peak / 1048576.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%lld", cpu.allocations);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", gpu.current / 1048576.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", gpu.peak / 1048576.0);
+    }
+};
+
+#ifdef MEMORY_TRACKER_IMPLEMENTATION
+// Global operators: tagged with the thread's current MemoryScope. Over-aligned new keeps
+// the standard library's own operators (and their matching deletes), untracked.
+void* operator new(size_t size) {
+    void* pointer = memoryAllocate(size, currentMemoryTag());
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    void* pointer = memoryAllocate(size, currentMemoryTag());
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t &) noexcept {
+    return memoryAllocate(size, currentMemoryTag());
+}
+
+void* operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return memoryAllocate(size, currentMemoryTag());
+}
+
+void operator delete(void* pointer) noexcept { memoryFree(pointer); }
+void operator delete[](void* pointer) noexcept { memoryFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { memoryFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { memoryFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t &) noexcept { memoryFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t &) noexcept { memoryFree(pointer); }
+#endif // MEMORY_TRACKER_IMPLEMENTATION
+
+#endif // MEMORY_TRACKER_HPP_
@@ -1,16 +1,21 @@
 #define MESH_HPP
-
+#include "./skeleton.hpp"
+#include "./profiler.hpp"
 
 struct Vertex {
     glm::vec3 Position;
     glm::vec3 Normal;
     glm::vec2 TexCoords;
+    uint8_t BoneIds[MAX_BONE_INFLUENCES];     // indices into the bone palette
+    uint8_t BoneWeights[MAX_BONE_INFLUENCES]; // unorm8, sum to 255 when skinned, all zero otherwise
 };
 
 struct Mesh {
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     GLuint VAO, VBO, EBO;
+    Skeleton skeleton;
+    std::vector<AnimationClip> animations;
 
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
         : vertices(vertices), indices(indices) {
@@ -25,6 +30,19 @@ struct Mesh {
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+        MemoryTracker::instance().gpuAllocated(MEM_MESHES, GPU_BUFFER, VBO, vertices.size() * sizeof(Vertex));
+        MemoryTracker::instance().gpuAllocated(MEM_MESHES, GPU_BUFFER, EBO, indices.size() * sizeof(unsigned int));
+        RenderStats::instance().bufferUpload(vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
+
+        bindVertexAttributes();
+
+        glBindVertexArray(0);
+    }
+
+    // Points attributes 0-4 of the bound VAO at this mesh's buffers; other VAOs can share them
+    void bindVertexAttributes() const {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
         glEnableVertexAttribArray(0);
@@ -35,12 +53,18 @@ struct Mesh {
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
         glEnableVertexAttribArray(2);
 
-        glBindVertexArray(0);
+        glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, BoneIds));
+        glEnableVertexAttribArray(3);
+
+        glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, BoneWeights));
+        glEnableVertexAttribArray(4);
     }
 
     void Draw(Shader &shader) {
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        RenderStats::instance().vertexArrayBind();
+        RenderStats::instance().draw(GL_TRIANGLES, (GLsizei)indices.size());
         glBindVertexArray(0);
     }
 };
@@ -65,21 +89,23 @@ void printBoneTransformations(const aiScene* scene) {
 
 
 Mesh loadModel(const std::string &path) {
+    PROFILE_ZONE("loadModel");
+    MemoryScope importMemory(MEM_ASSIMP);
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_LimitBoneWeights);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
         return Mesh({}, {});
     }
 
-    printBoneTransformations(scene);
-
     if (scene->mNumMeshes == 0) {
         std::cerr << "ERROR::ASSIMP::No meshes found in the model" << std::endl;
         return Mesh({}, {});
     }
 
+    // What the Mesh keeps; the scene is freed with the importer
+    MemoryScope meshMemory(MEM_MESHES);
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
 
@@ -99,6 +125,10 @@ Mesh loadModel(const std::string &path) {
         } else {
             vertex.TexCoords = glm::vec2(0.0f, 0.0f);
         }
+        for (int k = 0; k < MAX_BONE_INFLUENCES; k++) {
+            vertex.BoneIds[k] = 0;
+            vertex.BoneWeights[k] = 0;
+        }
         vertices.push_back(vertex);
     }
 
@@ -108,7 +138,18 @@ Mesh loadModel(const std::string &path) {
             indices.push_back(face.mIndices[j]);
     }
 
-    return Mesh(vertices, indices);
+    Skeleton skeleton;
+    std::vector<AnimationClip> animations;
+    if (mesh->HasBones()) {
+        importSkeleton(scene, mesh, skeleton, vertices);
+        importAnimations(scene, skeleton, animations);
+        std::cout << "Skeleton: " << skeleton.joints.size() << " joints, " << skeleton.inverseBind.size() << " bones" << std::endl;
+    }
+
+    Mesh result(vertices, indices);
+    result.skeleton = skeleton;
+    result.animations = animations;
+    return result;
 }
 
 
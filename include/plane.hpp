@@ -27,6 +27,7 @@ public:
 
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        MemoryTracker::instance().gpuAllocated(MEM_MESHES, GPU_BUFFER, VBO, vertices.size() * sizeof(float));
 
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(0);
@@ -52,5 +53,7 @@ public:
 
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        RenderStats::instance().vertexArrayBind();
+        RenderStats::instance().draw(GL_TRIANGLES, 6);
     }
 };
@@ -0,0 +1,141 @@
+#ifndef PRESENTER_HPP_
+#define PRESENTER_HPP_
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "./profiler.hpp"
+
+// Presentation: swap interval, frame cap and GPU queue depth.
+// present() runs on the thread that owns the GL context, once per frame:
+//  - applies a changed swap interval (adaptive vsync falls back to vsync without the tear extension)
+//  - waits for the frame cap deadline: sleep until shortly before it, then spin the rest,
+//    since plain sleeps overshoot by up to a scheduler tick
+//  - fences the frame and, with more than maxQueuedFrames in flight, waits for the oldest one,
+//    so the driver cannot buffer extra frames of input latency
+// Settings are written by the UI thread and picked up on the next present().
+
+enum SwapMode { SWAP_IMMEDIATE, SWAP_VSYNC, SWAP_ADAPTIVE };
+
+struct PresentStats {
+    float frameMs;      // present to present
+    float frameMsAvg;
+    float frameMsMax;   // over the last second
+    float latencyMs;    // input sampled to GPU done, for the last retired frame
+    float latencyMsAvg;
+    int queuedFrames;
+};
+
+class FramePresenter {
+public:
+    std::atomic<int> swapMode;
+    std::atomic<int> frameCap;        // frames per second, 0 for uncapped
+    std::atomic<int> maxQueuedFrames; // frames the GPU may lag behind, 1..3
+    bool headless; // no window surface to swap, only pacing; set before the first present()
+
+    FramePresenter() : swapMode(SWAP_VSYNC), frameCap(0), maxQueuedFrames(1), headless(false),
+                       appliedSwapMode(-1), lastPresent(0.0), windowStart(0.0), windowMax(0.0f), current() {}
+
+    // Needs the GL context
+    void destroy() {
+        for (const QueuedFrame &frame : queue)
+            glDeleteSync(frame.fence);
+        queue.clear();
+    }
+
+    // inputTime: glfwGetTime() when the frame's input was sampled
+    void present(GLFWwindow* window, double inputTime) {
+        PROFILE_ZONE("Present");
+        int mode = swapMode.load();
+        if (mode != appliedSwapMode && !headless) {
+            bool tear = glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear");
+            glfwSwapInterval(mode == SWAP_IMMEDIATE ? 0 : (mode == SWAP_ADAPTIVE && tear ? -1 : 1));
+            appliedSwapMode = mode;
+        }
+
+        int cap = frameCap.load();
+        if (cap > 0 && lastPresent > 0.0)
+            waitUntil(lastPresent + 1.0 / cap);
+
+        queue.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), inputTime });
+        if (!headless)
+            glfwSwapBuffers(window);
+
+        // Retire what the GPU already finished, then block on the oldest frame beyond the limit
+        int limit = std::max(1, std::min(maxQueuedFrames.load(), 3));
+        while (!queue.empty()) {
+            bool overLimit = (int)queue.size() > limit;
+            GLenum result = glClientWaitSync(queue.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, overLimit ? 100000000 : 0);
+            if (result == GL_WAIT_FAILED) {
+                // Nothing known about this frame: drop the fence, record no latency
+                std::cerr << "ERROR::PRESENTER::FENCE_WAIT_FAILED" << std::endl;
+                glDeleteSync(queue.front().fence);
+                queue.pop_front();
+                continue;
+            }
+            if (result == GL_TIMEOUT_EXPIRED) {
+                if (overLimit)
+                    continue; // keep waiting, the queue limit holds
+                break;
+            }
+            retire(queue.front());
+            queue.pop_front();
+        }
+
+        double now = glfwGetTime();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        if (lastPresent > 0.0) {
+            current.frameMs = (float)((now - lastPresent) * 1000.0);
+            current.frameMsAvg += (current.frameMs - current.frameMsAvg) * 0.05f;
+            windowMax = std::max(windowMax, current.frameMs);
+        }
+        if (now - windowStart >= 1.0) {
+            current.frameMsMax = windowMax;
+            windowMax = 0.0f;
+            windowStart = now;
+        }
+        current.queuedFrames = (int)queue.size();
+        lastPresent = now;
+    }
+
+    PresentStats stats() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return current;
+    }
+
+private:
+    struct QueuedFrame {
+        GLsync fence;
+        double inputTime;
+    };
+
+    std::deque<QueuedFrame> queue;
+    int appliedSwapMode;
+    double lastPresent;
+    double windowStart;
+    float windowMax;
+    std::mutex statsMutex;
+    PresentStats current;
+
+    void retire(const QueuedFrame &frame) {
+        float latency = (float)((glfwGetTime() - frame.inputTime) * 1000.0);
+        glDeleteSync(frame.fence);
+        std::lock_guard<std::mutex> lock(statsMutex);
+        current.latencyMs = latency;
+        current.latencyMsAvg += (latency - current.latencyMsAvg) * 0.05f;
+    }
+
+    static void waitUntil(double deadline) {
+        const double spinMargin = 0.002; // seconds left to the spin loop
+        double remaining = deadline - glfwGetTime();
+        if (remaining > spinMargin)
+            std::this_thread::sleep_for(std::chrono::duration<double>(remaining - spinMargin));
+        while (glfwGetTime() < deadline)
+            std::this_thread::yield();
+    }
+};
+
+#endif // PRESENTER_HPP_
@@ -0,0 +1,363 @@
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+#include "./imgui/imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./memory_tracker.hpp"
+
+// Hierarchical CPU profiler.
+//   PROFILE_ZONE("Name");   times the rest of the enclosing scope
+// Each thread appends finished zones to its own ring buffer; only that thread writes it,
+// so recording is two clock reads and a store, no locks. The UI reads the rings from
+// another thread: it copies a range and drops whatever the writer lapped meanwhile.
+// The main thread marks frames, the panel shows the last complete frame of every thread
+// as a flame graph plus rolling per-zone statistics.
+
+const int PROFILE_RING_SIZE = 1 << 14; // events per thread, power of two
+const int PROFILE_FRAME_HISTORY = 128;
+
+struct ProfileZone {
+    const char* name;
+};
+
+struct ProfileEvent {
+    const ProfileZone* zone;
+    int64_t begin, end; // nanoseconds, profileNow()
+    int depth;
+};
+
+// One GPU pass
+struct GpuScopeTiming {
+    const ProfileZone* zone;
+    float beginMs, endMs; // relative to the start of its frame on the GPU
+    int64_t begin, end;   // on the profileNow() clock
+};
+
+struct ProfileCounterSample {
+    const char* name; // string literal
+    int64_t time;
+    double value;
+};
+
+inline int64_t profileNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ProfileThread {
+    std::string name;
+    ProfileEvent events[PROFILE_RING_SIZE];
+    std::atomic<uint64_t> written;
+    int depth; // owner only
+
+    ProfileThread() : written(0), depth(0) {}
+};
+
+class Profiler {
+public:
+    static Profiler &instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // The calling thread's ring, registered on first use
+    ProfileThread &thread() {
+        static thread_local ProfileThread* current = nullptr;
+        if (!current) {
+            MemoryScope memory(MEM_PROFILER);
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.emplace_back(new ProfileThread());
+            current = threads.back().get();
+            current->name = "Thread " + std::to_string(threads.size());
+        }
+        return *current;
+    }
+
+    void setThreadName(const std::string &name) {
+        ProfileThread &t = thread();
+        std::lock_guard<std::mutex> lock(mutex);
+        t.name = name;
+    }
+
+    // Zones with a name only known at run time (render passes); interned, so keep the count small
+    const ProfileZone* zone(const std::string &name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<ProfileZone> &zone = dynamicZones[name];
+        if (!zone) {
+            names.emplace_back(new std::string(name));
+            zone.reset(new ProfileZone{ names.back()->c_str() });
+        }
+        return zone.get();
+    }
+
+    // Main thread, once per frame
+    void frameMark() {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameStarts[frameCount++ % PROFILE_FRAME_HISTORY] = profileNow();
+    }
+
+    // Start and end of the last complete frame; false before the second mark
+    bool lastFrame(int64_t &begin, int64_t &end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (frameCount < 2)
+            return false;
+        begin = frameStarts[(frameCount - 2) % PROFILE_FRAME_HISTORY];
+        end = frameStarts[(frameCount - 1) % PROFILE_FRAME_HISTORY];
+        return true;
+    }
+
+    // Newest GPU frame from GpuTimers, shown as an extra lane
+    void submitGpuFrame(const std::vector<GpuScopeTiming> &timings) {
+        std::lock_guard<std::mutex> lock(mutex);
+        gpuFrame = timings;
+        if (capturing)
+            capturedGpu.insert(capturedGpu.end(), timings.begin(), timings.end());
+    }
+
+    // Named value over time (bytes uploaded, passes run); only kept while a trace is captured
+    void counter(const char* name, double value) {
+        if (!capturing.load(std::memory_order_relaxed))
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        capturedCounters.push_back({ name, profileNow(), value });
+    }
+
+    // GPU frames and counters pile up between beginCapture() and endCapture()
+    void beginCapture() {
+        std::lock_guard<std::mutex> lock(mutex);
+        capturedGpu.clear();
+        capturedCounters.clear();
+        capturing = true;
+    }
+
+    void endCapture(std::vector<GpuScopeTiming> &gpu, std::vector<ProfileCounterSample> &counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        capturing = false;
+        gpu.swap(capturedGpu);
+        counters.swap(capturedCounters);
+    }
+
+    std::vector<GpuScopeTiming> lastGpuFrame() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return gpuFrame;
+    }
+
+    // Copies every event of every thread that overlaps [begin, end)
+    void collect(int64_t begin, int64_t end, std::vector<std::string> &threadNames, std::vector<std::vector<ProfileEvent>> &events) {
+        std::vector<ProfileThread*> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threadNames.clear();
+            for (auto &t : threads) {
+                snapshot.push_back(t.get());
+                threadNames.push_back(t->name);
+            }
+        }
+        events.resize(snapshot.size());
+        for (size_t i = 0; i < snapshot.size(); i++) {
+            ProfileThread &t = *snapshot[i];
+            events[i].clear();
+            uint64_t written = t.written.load(std::memory_order_acquire);
+            // The slot at written - PROFILE_RING_SIZE is the one being refilled next, skip it
+            uint64_t first = written >= PROFILE_RING_SIZE ? written - PROFILE_RING_SIZE + 1 : 0;
+            // Newest first: events are appended as they end, so stop at the first one that ended before `begin`
+            for (uint64_t k = written; k > first; k--) {
+                ProfileEvent event = t.events[(k - 1) & (PROFILE_RING_SIZE - 1)];
+                if (t.written.load(std::memory_order_acquire) - (k - 1) >= PROFILE_RING_SIZE)
+                    break; // lapped or being rewritten while copying
+                if (event.end < begin)
+                    break;
+                if (event.end >= begin && event.begin < end)
+                    events[i].push_back(event);
+            }
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileThread>> threads; // never freed, threads may outlive a lookup
+    std::map<std::string, std::unique_ptr<ProfileZone>> dynamicZones;
+    std::vector<std::unique_ptr<std::string>> names;
+    int64_t frameStarts[PROFILE_FRAME_HISTORY] = {};
+    uint64_t frameCount = 0;
+    std::vector<GpuScopeTiming> gpuFrame;
+    std::atomic<bool> capturing{ false };
+    std::vector<GpuScopeTiming> capturedGpu;
+    std::vector<ProfileCounterSample> capturedCounters;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const ProfileZone* zone) : zone(zone), thread(Profiler::instance().thread()) {
+        depth = thread.depth++;
+        begin = profileNow();
+    }
+
+    ~ProfileScope() {
+        int64_t end = profileNow();
+        uint64_t index = thread.written.load(std::memory_order_relaxed);
+        thread.events[index & (PROFILE_RING_SIZE - 1)] = { zone, begin, end, depth };
+        thread.written.store(index + 1, std::memory_order_release);
+        thread.depth--;
+    }
+
+private:
+    const ProfileZone* zone;
+    ProfileThread &thread;
+    int64_t begin;
+    int depth;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name)                                                       \
+    static const ProfileZone PROFILE_CONCAT(profileZone_, __LINE__) = { name }; \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(&PROFILE_CONCAT(profileZone_, __LINE__))
+
+// ImGui window: flame graph of the last frame per thread, then per-zone statistics.
+// The GPU lane is the newest resolved GPU frame, drawn from the start of the CPU frame
+// on the same scale so the two compare at a glance.
+class ProfilerPanel {
+public:
+    bool paused;
+
+    ProfilerPanel() : paused(false), frameBegin(0), frameEnd(0), historyIndex(0) {}
+
+    void draw() {
+        Profiler &profiler = Profiler::instance();
+        if (!paused && profiler.lastFrame(frameBegin, frameEnd)) {
+            profiler.collect(frameBegin, frameEnd, threadNames, events);
+            std::vector<ProfileEvent> gpu;
+            for (const GpuScopeTiming &timing : profiler.lastGpuFrame())
+                gpu.push_back({ timing.zone, frameBegin + (int64_t)(timing.beginMs * 1.0e6), frameBegin + (int64_t)(timing.endMs * 1.0e6), 0 });
+            if (!gpu.empty()) {
+                threadNames.push_back("GPU");
+                events.push_back(gpu);
+            }
+            accumulate();
+        }
+
+        ImGui::Begin("Profiler");
+        ImGui::Checkbox("Pause", &paused);
+        ImGui::SameLine();
+        ImGui::Text("Frame %.2f ms", (frameEnd - frameBegin) / 1.0e6);
+
+        for (size_t t = 0; t < events.size(); t++)
+            drawThread(threadNames[t], events[t]);
+
+        // Slowest zones first
+        if (ImGui::BeginTable("zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0.0f, 200.0f))) {
+            ImGui::TableSetupColumn("Zone");
+            ImGui::TableSetupColumn("Calls");
+            ImGui::TableSetupColumn("Avg ms");
+            ImGui::TableSetupColumn("Max ms");
+            ImGui::TableHeadersRow();
+            std::vector<std::pair<const ProfileZone*, ZoneStats*>> rows;
+            for (auto &entry : stats)
+                rows.push_back({ entry.first, &entry.second });
+            std::sort(rows.begin(), rows.end(), [](const std::pair<const ProfileZone*, ZoneStats*> &a, const std::pair<const ProfileZone*, ZoneStats*> &b) {
+                return a.second->average() > b.second->average();
+            });
+            for (auto &row : rows) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(row.first->name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", row.second->lastCalls);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", row.second->average());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", row.second->maximum());
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+private:
+    // Milliseconds per frame over the last PROFILE_FRAME_HISTORY frames
+    struct ZoneStats {
+        float history[PROFILE_FRAME_HISTORY] = {};
+        int lastCalls = 0;
+
+        float average() const {
+            float sum = 0.0f;
+            for (float ms : history)
+                sum += ms;
+            return sum / PROFILE_FRAME_HISTORY;
+        }
+
+        float maximum() const {
+            return *std::max_element(history, history + PROFILE_FRAME_HISTORY);
+        }
+    };
+
+    int64_t frameBegin, frameEnd;
+    std::vector<std::string> threadNames;
+    std::vector<std::vector<ProfileEvent>> events;
+    std::map<const ProfileZone*, ZoneStats> stats;
+    int historyIndex;
+
+    void accumulate() {
+        for (auto &entry : stats) {
+            entry.second.history[historyIndex] = 0.0f;
+            entry.second.lastCalls = 0;
+        }
+        for (const auto &thread : events) {
+            for (const ProfileEvent &event : thread) {
+                ZoneStats &zone = stats[event.zone];
+                int64_t clipped = std::min(event.end, frameEnd) - std::max(event.begin, frameBegin);
+                zone.history[historyIndex] += clipped / 1.0e6f;
+                zone.lastCalls++;
+            }
+        }
+        historyIndex = (historyIndex + 1) % PROFILE_FRAME_HISTORY;
+    }
+
+    static ImU32 zoneColor(const ProfileZone* zone) {
+        uint32_t hash = 2166136261u;
+        for (const char* c = zone->name; *c; c++)
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+        return IM_COL32(110 + hash % 120, 110 + (hash >> 8) % 120, 110 + (hash >> 16) % 120, 255);
+    }
+
+    void drawThread(const std::string &name, const std::vector<ProfileEvent> &thread) {
+        const float rowHeight = ImGui::GetTextLineHeight() + 2.0f;
+        int depth = 0;
+        for (const ProfileEvent &event : thread)
+            depth = std::max(depth, event.depth + 1);
+        ImGui::TextUnformatted(name.c_str());
+        if (depth == 0)
+            return;
+
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        float width = ImGui::GetContentRegionAvail().x;
+        ImGui::InvisibleButton(name.c_str(), ImVec2(width, depth * rowHeight));
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        double scale = width / (double)std::max<int64_t>(frameEnd - frameBegin, 1);
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+
+        for (const ProfileEvent &event : thread) {
+            float x0 = origin.x + (float)((std::max(event.begin, frameBegin) - frameBegin) * scale);
+            float x1 = origin.x + (float)((std::min(event.end, frameEnd) - frameBegin) * scale);
+            float y0 = origin.y + event.depth * rowHeight;
+            ImVec2 min(x0, y0), max(std::max(x1, x0 + 1.0f), y0 + rowHeight - 1.0f);
+            drawList->AddRectFilled(min, max, zoneColor(event.zone));
+            if (max.x - min.x > 30.0f) {
+                drawList->PushClipRect(min, max, true);
+                drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32(0, 0, 0, 255), event.zone->name);
+                drawList->PopClipRect();
+            }
+            if (ImGui::IsItemHovered() && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+                ImGui::SetTooltip("%s: %.3f ms", event.zone->name, (event.end - event.begin) / 1.0e6);
+        }
+    }
+};
+
+#endif // PROFILER_HPP_
@@ -0,0 +1,388 @@
+#ifndef RENDER_GRAPH_HPP_
+#define RENDER_GRAPH_HPP_
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./gpu_timer.hpp"
+#include "./profiler.hpp"
+#include "./render_stats.hpp"
+#include "./memory_tracker.hpp"
+
+// Render graph. Each frame the passes are declared with the targets they write and the
+// textures they read, then compile() works out what actually has to run:
+//  - passes whose results nothing reads are culled (walking back from the backbuffer)
+//  - the first write to a target clears it, unless the pass overwrites every pixel
+//  - transient targets get a texture from a pool when first used and hand it back after
+//    their last use, so later targets of the same format alias the same memory
+//  - targets are invalidated after their last use, so tiled GPUs skip storing them
+// Transient targets are allocated at window size and rendered at the (dynamic) render
+// size; the pool is rebuilt when the window size changes.
+// Every live pass is profiled on the CPU and, with timers attached, on the GPU, and
+// gets its own RenderStats counters.
+
+enum RenderFormat { FORMAT_RGBA8, FORMAT_DEPTH24_STENCIL8 };
+
+enum WriteMode {
+    WRITE_KEEP,    // draws over what is there (cleared first if nothing was)
+    WRITE_DISCARD, // overwrites every pixel, no clear and earlier writers are not needed
+};
+
+typedef int RenderResource;
+const RenderResource BACKBUFFER = 0;
+
+// Fixed function state a pass runs with; the graph sets it before every pass
+struct PassState {
+    bool depthTest = true;
+    bool stencilTest = true;
+    GLenum polygonMode = GL_FILL;
+};
+
+class RenderGraph;
+
+class RenderPassBuilder {
+public:
+    RenderResource create(const std::string &name, RenderFormat format);
+    void write(RenderResource resource, WriteMode mode = WRITE_KEEP);
+    void read(RenderResource resource);
+    void sideEffect(); // never culled, e.g. the UI before present
+    PassState &state();
+
+private:
+    friend class RenderGraph;
+    RenderGraph* graph;
+    int pass;
+};
+
+class RenderGraph {
+public:
+    struct Stats {
+        int passes, culled, clears, invalidations, pooledTextures;
+    };
+
+    GpuTimers* gpuTimers; // optional
+    GLuint backbufferFramebuffer; // 0 is the window; headless runs render into their own
+
+    RenderGraph() : gpuTimers(nullptr), backbufferFramebuffer(0), windowWidth(0), windowHeight(0), renderWidth(0), renderHeight(0) {
+        canInvalidate = GLEW_ARB_invalidate_subdata != 0;
+    }
+
+    // Window size drives allocation, render size the viewport of transient targets
+    void beginFrame(int window_w, int window_h, int render_w, int render_h) {
+        window_w = std::max(window_w, 1);
+        window_h = std::max(window_h, 1);
+        if (window_w != windowWidth || window_h != windowHeight)
+            releasePool();
+        windowWidth = window_w;
+        windowHeight = window_h;
+        renderWidth = std::min(std::max(render_w, 1), windowWidth);
+        renderHeight = std::min(std::max(render_h, 1), windowHeight);
+        passes.clear();
+        resources.clear();
+        resources.push_back({ "backbuffer", FORMAT_RGBA8, false });
+    }
+
+    void addPass(const std::string &name, const std::function<void(RenderPassBuilder &)> &setup,
+                 std::function<void(RenderGraph &)> execute) {
+        passes.push_back(Pass());
+        passes.back().name = name;
+        passes.back().zone = Profiler::instance().zone(name);
+        passes.back().gpuZone = Profiler::instance().zone("GPU " + name);
+        passes.back().execute = std::move(execute);
+        RenderPassBuilder builder;
+        builder.graph = this;
+        builder.pass = (int)passes.size() - 1;
+        setup(builder);
+    }
+
+    // GL texture behind a transient target; valid while executing a pass that reads it
+    GLuint texture(RenderResource resource) const {
+        int slot = resources[resource].poolSlot;
+        return slot < 0 ? 0 : pool[slot].texture;
+    }
+
+    // Render size over allocated size, for sampling a transient target
+    glm::vec2 uvScale() const {
+        return glm::vec2((float)renderWidth / windowWidth, (float)renderHeight / windowHeight);
+    }
+
+    glm::vec2 targetSize() const {
+        return glm::vec2((float)windowWidth, (float)windowHeight);
+    }
+
+    void compile() {
+        // Liveness, back to front: a pass lives if it has side effects or writes something
+        // a later live pass needs
+        std::vector<bool> needed(resources.size(), false);
+        needed[BACKBUFFER] = true;
+        for (int p = (int)passes.size() - 1; p >= 0; p--) {
+            Pass &pass = passes[p];
+            pass.live = pass.sideEffect;
+            for (const Access &access : pass.writes)
+                pass.live = pass.live || needed[access.resource];
+            if (!pass.live)
+                continue;
+            for (const Access &access : pass.writes)
+                needed[access.resource] = access.mode == WRITE_KEEP;
+            for (RenderResource resource : pass.reads)
+                needed[resource] = true;
+        }
+
+        // Lifetimes and clears over the live passes
+        for (Resource &resource : resources) {
+            resource.firstUse = resource.lastUse = -1;
+            resource.poolSlot = -1;
+        }
+        for (int p = 0; p < (int)passes.size(); p++) {
+            Pass &pass = passes[p];
+            if (!pass.live)
+                continue;
+            pass.clears.clear();
+            for (const Access &access : pass.writes) {
+                Resource &resource = resources[access.resource];
+                if (resource.firstUse < 0 && access.mode == WRITE_KEEP)
+                    pass.clears.push_back(access.resource);
+                touch(resource, p);
+            }
+            for (RenderResource resource : pass.reads)
+                touch(resources[resource], p);
+        }
+    }
+
+    void execute() {
+        Stats frameStats = Stats();
+        for (int p = 0; p < (int)passes.size(); p++) {
+            Pass &pass = passes[p];
+            if (!pass.live) {
+                frameStats.culled++;
+                continue;
+            }
+            frameStats.passes++;
+
+            // Targets whose lifetime starts here take a pooled texture
+            for (Resource &resource : resources)
+                if (resource.transient && resource.firstUse == p)
+                    resource.poolSlot = acquire(resource.format);
+
+            bool toBackbuffer = false;
+            GLuint color = 0, depth = 0;
+            for (const Access &access : pass.writes) {
+                if (access.resource == BACKBUFFER)
+                    toBackbuffer = true;
+                else if (resources[access.resource].format == FORMAT_DEPTH24_STENCIL8)
+                    depth = texture(access.resource);
+                else
+                    color = texture(access.resource);
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, toBackbuffer ? backbufferFramebuffer : framebuffer(color, depth));
+            if (toBackbuffer)
+                glViewport(0, 0, windowWidth, windowHeight);
+            else
+                glViewport(0, 0, renderWidth, renderHeight);
+
+            if (!pass.clears.empty()) {
+                GLbitfield mask = 0;
+                for (RenderResource resource : pass.clears)
+                    mask |= resource != BACKBUFFER && resources[resource].format == FORMAT_DEPTH24_STENCIL8
+                        ? GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT : GL_COLOR_BUFFER_BIT;
+                // Clears honour the write masks
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                glDepthMask(GL_TRUE);
+                glStencilMask(0xFF);
+                glClear(mask);
+                frameStats.clears++;
+            }
+
+            setEnabled(GL_DEPTH_TEST, pass.state.depthTest);
+            setEnabled(GL_STENCIL_TEST, pass.state.stencilTest);
+            glPolygonMode(GL_FRONT_AND_BACK, pass.state.polygonMode);
+            {
+                ProfileScope scope(pass.zone);
+                RenderCounters before = RenderStats::instance().counters();
+                int gpuScope = gpuTimers ? gpuTimers->begin(pass.gpuZone) : -1;
+                pass.execute(*this);
+                if (gpuTimers)
+                    gpuTimers->end(gpuScope);
+                RenderStats::instance().pass(pass.name, before);
+            }
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+            // Contents nobody reads again: drop them and give the texture back to the pool
+            std::vector<GLenum> invalidate;
+            for (const Access &access : pass.writes) {
+                const Resource &resource = resources[access.resource];
+                if (resource.transient && resource.lastUse == p)
+                    invalidate.push_back(resource.format == FORMAT_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_COLOR_ATTACHMENT0);
+            }
+            if (canInvalidate && !invalidate.empty() && !toBackbuffer) {
+                glInvalidateFramebuffer(GL_FRAMEBUFFER, (GLsizei)invalidate.size(), invalidate.data());
+                frameStats.invalidations += (int)invalidate.size();
+            }
+            for (Resource &resource : resources)
+                if (resource.transient && resource.lastUse == p)
+                    pool[resource.poolSlot].inUse = false;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        frameStats.pooledTextures = (int)pool.size();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        lastStats = frameStats;
+    }
+
+    // Any thread
+    Stats stats() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return lastStats;
+    }
+
+    void destroy() {
+        releasePool();
+    }
+
+private:
+    friend class RenderPassBuilder;
+
+    struct Access {
+        RenderResource resource;
+        WriteMode mode;
+    };
+
+    struct Pass {
+        std::string name;
+        const ProfileZone* zone;
+        const ProfileZone* gpuZone;
+        std::function<void(RenderGraph &)> execute;
+        std::vector<Access> writes;
+        std::vector<RenderResource> reads;
+        std::vector<RenderResource> clears;
+        PassState state;
+        bool sideEffect = false;
+        bool live = false;
+    };
+
+    struct Resource {
+        std::string name;
+        RenderFormat format;
+        bool transient;
+        int firstUse = -1, lastUse = -1; // live pass indices
+        int poolSlot = -1;
+    };
+
+    struct PooledTexture {
+        GLuint texture;
+        RenderFormat format;
+        bool inUse;
+    };
+
+    struct CachedFramebuffer {
+        GLuint color, depth, FBO;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<PooledTexture> pool;
+    std::vector<CachedFramebuffer> framebuffers;
+    int windowWidth, windowHeight;
+    int renderWidth, renderHeight;
+    bool canInvalidate;
+    std::mutex statsMutex;
+    Stats lastStats = Stats();
+
+    static void touch(Resource &resource, int pass) {
+        if (resource.firstUse < 0)
+            resource.firstUse = pass;
+        resource.lastUse = pass;
+    }
+
+    static void setEnabled(GLenum capability, bool enabled) {
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    int acquire(RenderFormat format) {
+        for (size_t i = 0; i < pool.size(); i++) {
+            if (!pool[i].inUse && pool[i].format == format) {
+                pool[i].inUse = true;
+                return (int)i;
+            }
+        }
+
+        PooledTexture entry = { 0, format, true };
+        glGenTextures(1, &entry.texture);
+        MemoryTracker::instance().gpuAllocated(MEM_RENDERER, GPU_TEXTURE, entry.texture, (size_t)windowWidth * windowHeight * 4); // RGBA8 or D24S8
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+        if (format == FORMAT_DEPTH24_STENCIL8)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, windowWidth, windowHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, windowWidth, windowHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        GLint filter = format == FORMAT_DEPTH24_STENCIL8 ? GL_NEAREST : GL_LINEAR;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        pool.push_back(entry);
+        return (int)pool.size() - 1;
+    }
+
+    GLuint framebuffer(GLuint color, GLuint depth) {
+        for (const CachedFramebuffer &cached : framebuffers)
+            if (cached.color == color && cached.depth == depth)
+                return cached.FBO;
+
+        CachedFramebuffer cached = { color, depth, 0 };
+        glGenFramebuffers(1, &cached.FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, cached.FBO);
+        if (color != 0)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+        else
+            glDrawBuffer(GL_NONE);
+        if (depth != 0)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        framebuffers.push_back(cached);
+        return cached.FBO;
+    }
+
+    void releasePool() {
+        for (const CachedFramebuffer &cached : framebuffers)
+            glDeleteFramebuffers(1, &cached.FBO);
+        framebuffers.clear();
+        for (const PooledTexture &entry : pool)
+        {
+            MemoryTracker::instance().gpuFreed(GPU_TEXTURE, entry.texture);
+            glDeleteTextures(1, &entry.texture);
+        }
+        pool.clear();
+    }
+};
+
+inline RenderResource RenderPassBuilder::create(const std::string &name, RenderFormat format) {
+    RenderGraph::Resource resource;
+    resource.name = name;
+    resource.format = format;
+    resource.transient = true;
+    graph->resources.push_back(resource);
+    return (RenderResource)graph->resources.size() - 1;
+}
+
+inline void RenderPassBuilder::write(RenderResource resource, WriteMode mode) {
+    graph->passes[pass].writes.push_back({ resource, mode });
+}
+
+inline void RenderPassBuilder::read(RenderResource resource) {
+    graph->passes[pass].reads.push_back(resource);
+}
+
+inline void RenderPassBuilder::sideEffect() {
+    graph->passes[pass].sideEffect = true;
+}
+
+inline PassState &RenderPassBuilder::state() {
+    return graph->passes[pass].state;
+}
+
+#endif // RENDER_GRAPH_HPP_
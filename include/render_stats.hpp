@@ -0,0 +1,183 @@
+#ifndef RENDER_STATS_HPP_
+#define RENDER_STATS_HPP_
+#include "./imgui/imgui.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Renderer statistics: draws, triangles, state changes and upload bytes.
+// The code issuing the GL call counts it right there (RenderStats::instance().draw(...)),
+// into running totals owned by the thread holding the GL context. The render graph
+// takes the difference around every pass; endFrame() publishes the frame, which any
+// thread can read with lastFrame(). Work outside the graph (mesh uploads, the camera
+// buffer) shows up in the frame total only.
+// ImGui's backend draws from its own translation unit; the UI pass counts its draw lists.
+
+struct RenderCounters {
+    long long draws = 0;
+    long long triangles = 0;
+    long long programBinds = 0;
+    long long vertexArrayBinds = 0;
+    long long textureBinds = 0;
+    long long uniformCalls = 0;
+    long long bufferUploadBytes = 0;
+    long long textureUploadBytes = 0;
+
+    RenderCounters &operator+=(const RenderCounters &other) {
+        draws += other.draws;
+        triangles += other.triangles;
+        programBinds += other.programBinds;
+        vertexArrayBinds += other.vertexArrayBinds;
+        textureBinds += other.textureBinds;
+        uniformCalls += other.uniformCalls;
+        bufferUploadBytes += other.bufferUploadBytes;
+        textureUploadBytes += other.textureUploadBytes;
+        return *this;
+    }
+
+    RenderCounters operator-(const RenderCounters &other) const {
+        RenderCounters result;
+        result.draws = draws - other.draws;
+        result.triangles = triangles - other.triangles;
+        result.programBinds = programBinds - other.programBinds;
+        result.vertexArrayBinds = vertexArrayBinds - other.vertexArrayBinds;
+        result.textureBinds = textureBinds - other.textureBinds;
+        result.uniformCalls = uniformCalls - other.uniformCalls;
+        result.bufferUploadBytes = bufferUploadBytes - other.bufferUploadBytes;
+        result.textureUploadBytes = textureUploadBytes - other.textureUploadBytes;
+        return result;
+    }
+};
+
+struct RenderPassCounters {
+    std::string name;
+    RenderCounters counters;
+};
+
+struct RenderFrameStats {
+    RenderCounters total;
+    std::vector<RenderPassCounters> passes;
+};
+
+class RenderStats {
+public:
+    static RenderStats &instance() {
+        static RenderStats stats;
+        return stats;
+    }
+
+    // Counting, GL thread only
+    void draw(GLenum mode, GLsizei count, GLsizei instances = 1) {
+        running.draws++;
+        if (mode == GL_TRIANGLES)
+            running.triangles += (long long)(count / 3) * instances;
+        else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+            running.triangles += (long long)std::max(count - 2, 0) * instances;
+    }
+    void programBind() { running.programBinds++; }
+    void vertexArrayBind() { running.vertexArrayBinds++; }
+    void textureBind() { running.textureBinds++; }
+    void uniformCall() { running.uniformCalls++; }
+    void bufferUpload(size_t bytes) { running.bufferUploadBytes += (long long)bytes; }
+    void textureUpload(size_t bytes) { running.textureUploadBytes += (long long)bytes; }
+
+    // Totals since startup, for taking differences
+    const RenderCounters &counters() const {
+        return running;
+    }
+
+    // A pass of the current frame did everything counted since `before`
+    void pass(const std::string &name, const RenderCounters &before) {
+        frame.passes.push_back({ name, running - before });
+    }
+
+    // What ImGui's backend does for this draw data: one draw and texture bind per command,
+    // vertex and index buffers streamed every frame
+    void uiDrawData(const ImDrawData &data) {
+        if (data.CmdLists.Size == 0)
+            return;
+        running.programBinds++;
+        running.vertexArrayBinds++;
+        for (const ImDrawList* list : data.CmdLists) {
+            running.bufferUploadBytes += (long long)list->VtxBuffer.Size * sizeof(ImDrawVert) + (long long)list->IdxBuffer.Size * sizeof(ImDrawIdx);
+            for (const ImDrawCmd &command : list->CmdBuffer) {
+                if (command.UserCallback)
+                    continue;
+                draw(GL_TRIANGLES, (GLsizei)command.ElemCount);
+                running.textureBinds++;
+            }
+        }
+    }
+
+    // GL thread, after the frame's last GL call; returns the frame's totals
+    RenderCounters endFrame() {
+        frame.total = running - frameStart;
+        frameStart = running;
+        std::lock_guard<std::mutex> lock(statsMutex);
+        published.total = frame.total;
+        published.passes.swap(frame.passes);
+        frame.passes.clear();
+        return published.total;
+    }
+
+    // Any thread
+    RenderFrameStats lastFrame() {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        return published;
+    }
+
+private:
+    RenderCounters running;
+    RenderCounters frameStart;
+    RenderFrameStats frame;
+    std::mutex statsMutex;
+    RenderFrameStats published;
+
+    RenderStats() {}
+};
+
+// Table of the last frame, one row per pass
+class RenderStatsPanel {
+public:
+    void draw() {
+        RenderFrameStats stats = RenderStats::instance().lastFrame();
+        ImGui::Begin("Renderer stats");
+        ImGui::Text("%lld draws, %lld triangles, %.1f KB buffers and %.1f KB textures uploaded", stats.total.draws, stats.total.triangles,
+                    stats.total.bufferUploadBytes / 1024.0, stats.total.textureUploadBytes / 1024.0);
+        if (ImGui::BeginTable("passes", 9, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            const char* columns[9] = { "Pass", "Draws", "Triangles", "Programs", "VAOs", "Textures", "Uniforms", "Buffer KB", "Texture KB" };
+            for (const char* column : columns)
+                ImGui::TableSetupColumn(column);
+            ImGui::TableHeadersRow();
+            RenderCounters inPasses;
+            for (const RenderPassCounters &pass : stats.passes) {
+                row(pass.name.c_str(), pass.counters);
+                inPasses += pass.counters;
+            }
+            row("Outside passes", stats.total - inPasses);
+            row("Frame", stats.total);
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+private:
+    static void row(const char* name, const RenderCounters &counters) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        long long values[6] = { counters.draws, counters.triangles, counters.programBinds, counters.vertexArrayBinds,
+                                counters.textureBinds, counters.uniformCalls };
+        for (long long value : values) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%lld", value);
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", counters.bufferUploadBytes / 1024.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", counters.textureUploadBytes / 1024.0);
+    }
+};
+
+#endif // RENDER_STATS_HPP_
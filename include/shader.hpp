@@ -1,4 +1,6 @@
 #define SHADER_HPP
+#include "./render_stats.hpp"
+#include "./memory_tracker.hpp"
 
 // Vertex shader for the outline
 const char* modelOutlineVertexShaderSource = R"(
@@ -8,8 +10,10 @@ layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
@@ -38,8 +42,10 @@ layout(location = 2) in vec2 aTexCoord;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
@@ -48,6 +54,97 @@ void main()
 }
 )";
 
+// Vertex shader for skinned models, bone matrices come from the BonePalette uniform block
+const char* skinnedModelVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in uvec4 aBoneIds;
+layout(location = 4) in vec4 aBoneWeights;
+
+out vec2 TexCoord;
+
+const int MAX_BONES = 128; // keep in sync with skeleton.hpp
+layout(std140) uniform BonePalette {
+    mat4 bones[MAX_BONES];
+};
+
+uniform mat4 model;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    mat4 skin = aBoneWeights.x * bones[aBoneIds.x] +
+                aBoneWeights.y * bones[aBoneIds.y] +
+                aBoneWeights.z * bones[aBoneIds.z] +
+                aBoneWeights.w * bones[aBoneIds.w];
+    // Vertices without influences stay in bind pose
+    if (dot(aBoneWeights, vec4(1.0)) == 0.0)
+        skin = mat4(1.0);
+    gl_Position = projection * view * model * skin * vec4(aPos, 1.0);
+    TexCoord = aTexCoord;
+}
+)";
+
+// Instanced crowd: bone palettes come from a baked animation texture (see vertex_anim.hpp)
+const char* crowdVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in uvec4 aBoneIds;
+layout(location = 4) in vec4 aBoneWeights;
+layout(location = 5) in vec4 aPlacement; // xyz position, w yaw
+layout(location = 6) in vec4 aAnimation; // first frame, frame count, time offset, speed
+
+out vec2 TexCoord;
+
+uniform sampler2D animationTexture;
+uniform float animationTime;
+uniform float animationSampleRate;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+
+mat4 fetchBone(int frame, uint bone) {
+    int x = int(bone) * 3;
+    vec4 r0 = texelFetch(animationTexture, ivec2(x, frame), 0);
+    vec4 r1 = texelFetch(animationTexture, ivec2(x + 1, frame), 0);
+    vec4 r2 = texelFetch(animationTexture, ivec2(x + 2, frame), 0);
+    return transpose(mat4(r0, r1, r2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+mat4 skinAt(int frame) {
+    return aBoneWeights.x * fetchBone(frame, aBoneIds.x) +
+           aBoneWeights.y * fetchBone(frame, aBoneIds.y) +
+           aBoneWeights.z * fetchBone(frame, aBoneIds.z) +
+           aBoneWeights.w * fetchBone(frame, aBoneIds.w);
+}
+
+void main()
+{
+    // Loop over the clip's rows and blend the two neighbouring frames
+    float frames = aAnimation.y - 1.0;
+    float frame = mod((animationTime * aAnimation.w + aAnimation.z) * animationSampleRate, frames);
+    int f0 = int(frame);
+    int first = int(aAnimation.x);
+    float t = fract(frame);
+    mat4 skin = skinAt(first + f0) * (1.0 - t) + skinAt(first + f0 + 1) * t;
+    if (dot(aBoneWeights, vec4(1.0)) == 0.0)
+        skin = mat4(1.0);
+
+    float c = cos(aPlacement.w), s = sin(aPlacement.w);
+    mat4 model = mat4(vec4(c, 0.0, -s, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(s, 0.0, c, 0.0), vec4(aPlacement.xyz, 1.0));
+    gl_Position = projection * view * model * skin * vec4(aPos, 1.0);
+    TexCoord = aTexCoord;
+}
+)";
+
 // Fragment shader for the model with textures
 const char* modelFragmentShaderSource = R"(
 #version 330 core
@@ -79,8 +176,10 @@ layout(location = 1) in vec2 aTexCoord;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
@@ -150,8 +249,10 @@ layout(triangles) in;
 layout(triangle_strip, max_vertices = 3) out;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 out vec2 TexCoord;
 
@@ -176,6 +277,109 @@ void main()
 }
 )";
 
+// Vertex shader for voxel chunks, unpacks the 8-byte ChunkVertex (see chunk_mesh.hpp)
+const char* chunkVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in uvec2 aData;
+
+out vec2 TexCoord;
+out float Brightness;
+flat out int BlockType;
+
+uniform vec3 chunkOrigin;
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
+uniform float daylight; // scales sky light, block light is unaffected
+
+const vec2 cornerTexCoords[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+// +X, -X, +Y, -Y, +Z, -Z
+const float faceShade[6] = float[6](0.8, 0.8, 1.0, 0.5, 0.9, 0.9);
+
+void main()
+{
+    uint d = aData.x;
+    vec3 pos = vec3(float(d & 31u), float((d >> 5) & 31u), float((d >> 10) & 31u));
+    uint normal = (d >> 15) & 7u;
+    uint corner = (d >> 18) & 3u;
+    float occlusion = float((d >> 20) & 3u);
+    float sky = float((d >> 22) & 15u) / 15.0;
+    float block = float((d >> 26) & 15u) / 15.0;
+
+    gl_Position = projection * view * vec4(chunkOrigin + pos, 1.0);
+    TexCoord = cornerTexCoords[corner];
+    float light = max(sky * daylight, block);
+    float ao = 0.55 + 0.15 * occlusion; // 0.55 in a fully occluded corner, 1.0 when open
+    Brightness = mix(0.05, 1.0, light * light) * ao * faceShade[normal];
+    BlockType = int(aData.y & 0xFFFFu);
+}
+)";
+
+// Fragment shader for voxel chunks
+const char* chunkFragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+in float Brightness;
+flat in int BlockType;
+
+void main()
+{
+    vec3 colors[5] = vec3[5](
+        vec3(0.0),                  // air
+        vec3(0.600, 0.902, 0.373),  // grass #99e65f
+        vec3(0.545, 0.376, 0.243),  // dirt
+        vec3(0.500, 0.500, 0.520),  // stone
+        vec3(1.000, 0.850, 0.500)   // lamp
+    );
+    vec2 grid = floor(TexCoord * 4.0);
+    float checker = mod(grid.x + grid.y, 2.0) == 0.0 ? 1.0 : 0.9;
+    FragColor = vec4(colors[BlockType] * checker * Brightness, 1.0);
+}
+)";
+
+// Fullscreen triangle from gl_VertexID, drawn with an empty VAO
+const char* upscaleVertexShaderSource = R"(
+#version 330 core
+out vec2 TexCoord;
+
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// Bilinear upscale of the rendered part of the scene texture plus an optional
+// unsharp mask to win back some of the detail lost to the lower resolution
+const char* upscaleFragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D scene;
+uniform vec2 uvScale;   // rendered size / texture size
+uniform vec2 texelSize; // 1 / texture size
+uniform float sharpness;
+
+void main()
+{
+    // Stay half a texel inside the rendered area, outside of it is stale
+    vec2 uv = min(TexCoord * uvScale, uvScale - 0.5 * texelSize);
+    vec3 color = texture(scene, uv).rgb;
+    if (sharpness > 0.0) {
+        vec3 blur = texture(scene, uv + vec2(texelSize.x, 0.0)).rgb + texture(scene, uv - vec2(texelSize.x, 0.0)).rgb +
+                    texture(scene, uv + vec2(0.0, texelSize.y)).rgb + texture(scene, uv - vec2(0.0, texelSize.y)).rgb;
+        color = clamp(color + (color - blur * 0.25) * sharpness, 0.0, 1.0);
+    }
+    FragColor = vec4(color, 1.0);
+}
+)";
+
 // Функция для компиляции шейдера
 GLuint compileShader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
@@ -272,18 +476,39 @@ public:
 
     void use() {
         glUseProgram(ID);
+        RenderStats::instance().programBind();
+    }
+
+    // GLSL 330 has no layout(binding), so uniform blocks are bound from here
+    void bindUniformBlock(const std::string &name, GLuint binding) const {
+        GLuint index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
     }
 
     void setMat4(const std::string &name, const glm::mat4 &mat) const {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderStats::instance().uniformCall();
+    }
+
+    void setVec2(const std::string &name, const glm::vec2 &value) const {
+        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RenderStats::instance().uniformCall();
+    }
+
+    void setVec3(const std::string &name, const glm::vec3 &value) const {
+        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        RenderStats::instance().uniformCall();
     }
 
     void setFloat(const std::string &name, float value) const {
         glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        RenderStats::instance().uniformCall();
     }
 
     void setInt(const std::string &name, int value) const {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        RenderStats::instance().uniformCall();
     }
 };
 
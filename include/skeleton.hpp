@@ -0,0 +1,218 @@
+#ifndef SKELETON_HPP_
+#define SKELETON_HPP_
+#include "./includes.hpp"
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include "./memory_tracker.hpp"
+
+const int MAX_BONES = 128;        // size of the BonePalette uniform block
+const int MAX_BONE_INFLUENCES = 4;
+
+inline glm::mat4 toGlm(const aiMatrix4x4 &m) {
+    // Assimp matrices are row-major
+    return glm::mat4(glm::vec4(m.a1, m.b1, m.c1, m.d1),
+                     glm::vec4(m.a2, m.b2, m.c2, m.d2),
+                     glm::vec4(m.a3, m.b3, m.c3, m.d3),
+                     glm::vec4(m.a4, m.b4, m.c4, m.d4));
+}
+
+// Node hierarchy flattened so that parents always come before their children
+struct Joint {
+    std::string name;
+    int parent;            // -1 for the root
+    int bone;              // index into the bone palette, -1 if no vertices are bound to it
+    glm::mat4 bindLocal;   // node transform used when a clip has no track for this joint
+};
+
+struct Skeleton {
+    std::vector<Joint> joints;
+    std::vector<glm::mat4> inverseBind; // per bone, aiBone::mOffsetMatrix
+    glm::mat4 globalInverse;
+
+    Skeleton() : globalInverse(1.0f) {}
+
+    bool empty() const { return inverseBind.empty(); }
+
+    int findJoint(const std::string &name) const {
+        for (size_t i = 0; i < joints.size(); i++)
+            if (joints[i].name == name)
+                return (int)i;
+        return -1;
+    }
+};
+
+template <typename T>
+struct Keyframe {
+    float time; // seconds
+    T value;
+};
+
+struct JointTrack {
+    std::vector<Keyframe<glm::vec3>> positions;
+    std::vector<Keyframe<glm::quat>> rotations;
+    std::vector<Keyframe<glm::vec3>> scales;
+};
+
+struct AnimationClip {
+    std::string name;
+    float duration; // seconds
+    std::vector<JointTrack> tracks; // one per skeleton joint, empty when the joint is not animated
+};
+
+void flattenNodes(const aiNode* node, int parent, Skeleton &skeleton) {
+    int index = (int)skeleton.joints.size();
+    skeleton.joints.push_back({ node->mName.C_Str(), parent, -1, toGlm(node->mTransformation) });
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+        flattenNodes(node->mChildren[i], index, skeleton);
+}
+
+// Reads the node hierarchy and aiMesh::mBones, and fills the bone ids/weights of `vertices`.
+// Vertex must expose BoneIds[4] and BoneWeights[4] (uint8, weights as unorm8).
+template <typename VertexT>
+void importSkeleton(const aiScene* scene, const aiMesh* mesh, Skeleton &skeleton, std::vector<VertexT> &vertices) {
+    skeleton = Skeleton();
+    flattenNodes(scene->mRootNode, -1, skeleton);
+    skeleton.globalInverse = glm::inverse(toGlm(scene->mRootNode->mTransformation));
+
+    std::vector<float> weights(vertices.size() * MAX_BONE_INFLUENCES, 0.0f);
+    std::vector<uint8_t> ids(vertices.size() * MAX_BONE_INFLUENCES, 0);
+
+    unsigned int boneCount = std::min(mesh->mNumBones, (unsigned int)MAX_BONES);
+    if (mesh->mNumBones > (unsigned int)MAX_BONES)
+        std::cerr << "WARNING::SKELETON::" << mesh->mNumBones << " bones, only " << MAX_BONES << " are used" << std::endl;
+
+    for (unsigned int b = 0; b < boneCount; b++) {
+        const aiBone* bone = mesh->mBones[b];
+        int joint = skeleton.findJoint(bone->mName.C_Str());
+        if (joint < 0) {
+            std::cerr << "ERROR::SKELETON::Bone without node: " << bone->mName.C_Str() << std::endl;
+            continue;
+        }
+        skeleton.joints[joint].bone = (int)skeleton.inverseBind.size();
+        skeleton.inverseBind.push_back(toGlm(bone->mOffsetMatrix));
+
+        for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+            unsigned int v = bone->mWeights[w].mVertexId;
+            float weight = bone->mWeights[w].mWeight;
+            // Keep the four strongest influences
+            float* slot = &weights[v * MAX_BONE_INFLUENCES];
+            int weakest = (int)(std::min_element(slot, slot + MAX_BONE_INFLUENCES) - slot);
+            if (weight > slot[weakest]) {
+                slot[weakest] = weight;
+                ids[v * MAX_BONE_INFLUENCES + weakest] = (uint8_t)skeleton.joints[joint].bone;
+            }
+        }
+    }
+
+    // Quantize to unorm8 so that the four weights still sum to exactly 255
+    for (size_t v = 0; v < vertices.size(); v++) {
+        float* slot = &weights[v * MAX_BONE_INFLUENCES];
+        float sum = slot[0] + slot[1] + slot[2] + slot[3];
+        int total = 0, strongest = 0;
+        for (int k = 0; k < MAX_BONE_INFLUENCES; k++) {
+            int q = sum > 0.0f ? (int)(slot[k] / sum * 255.0f + 0.5f) : 0;
+            vertices[v].BoneIds[k] = ids[v * MAX_BONE_INFLUENCES + k];
+            vertices[v].BoneWeights[k] = (uint8_t)q;
+            total += q;
+            if (slot[k] > slot[strongest])
+                strongest = k;
+        }
+        if (total > 0)
+            vertices[v].BoneWeights[strongest] = (uint8_t)(vertices[v].BoneWeights[strongest] + 255 - total);
+    }
+}
+
+void importAnimations(const aiScene* scene, const Skeleton &skeleton, std::vector<AnimationClip> &clips) {
+    clips.clear();
+    for (unsigned int a = 0; a < scene->mNumAnimations; a++) {
+        const aiAnimation* anim = scene->mAnimations[a];
+        float ticksPerSecond = anim->mTicksPerSecond > 0.0 ? (float)anim->mTicksPerSecond : 25.0f;
+
+        AnimationClip clip;
+        clip.name = anim->mName.C_Str();
+        clip.duration = (float)anim->mDuration / ticksPerSecond;
+        clip.tracks.resize(skeleton.joints.size());
+
+        for (unsigned int c = 0; c < anim->mNumChannels; c++) {
+            const aiNodeAnim* channel = anim->mChannels[c];
+            int joint = skeleton.findJoint(channel->mNodeName.C_Str());
+            if (joint < 0)
+                continue;
+            JointTrack &track = clip.tracks[joint];
+            for (unsigned int k = 0; k < channel->mNumPositionKeys; k++) {
+                const aiVectorKey &key = channel->mPositionKeys[k];
+                track.positions.push_back({ (float)key.mTime / ticksPerSecond, glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z) });
+            }
+            for (unsigned int k = 0; k < channel->mNumRotationKeys; k++) {
+                const aiQuatKey &key = channel->mRotationKeys[k];
+                track.rotations.push_back({ (float)key.mTime / ticksPerSecond, glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z) });
+            }
+            for (unsigned int k = 0; k < channel->mNumScalingKeys; k++) {
+                const aiVectorKey &key = channel->mScalingKeys[k];
+                track.scales.push_back({ (float)key.mTime / ticksPerSecond, glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z) });
+            }
+        }
+        std::cout << "Loaded animation: " << clip.name << " (" << clip.duration << "s)" << std::endl;
+        clips.push_back(clip);
+    }
+}
+
+// Index of the last key at or before t
+template <typename T>
+size_t findKey(const std::vector<Keyframe<T>> &keys, float t) {
+    auto it = std::upper_bound(keys.begin(), keys.end(), t,
+                               [](float time, const Keyframe<T> &key) { return time < key.time; });
+    return it == keys.begin() ? 0 : (size_t)(it - keys.begin()) - 1;
+}
+
+inline glm::vec3 sampleKeys(const std::vector<Keyframe<glm::vec3>> &keys, float t) {
+    size_t i = findKey(keys, t);
+    if (i + 1 >= keys.size())
+        return keys[i].value;
+    float f = (t - keys[i].time) / (keys[i + 1].time - keys[i].time);
+    return glm::mix(keys[i].value, keys[i + 1].value, glm::clamp(f, 0.0f, 1.0f));
+}
+
+inline glm::quat sampleKeys(const std::vector<Keyframe<glm::quat>> &keys, float t) {
+    size_t i = findKey(keys, t);
+    if (i + 1 >= keys.size())
+        return keys[i].value;
+    float f = (t - keys[i].time) / (keys[i + 1].time - keys[i].time);
+    return glm::normalize(glm::slerp(keys[i].value, keys[i + 1].value, glm::clamp(f, 0.0f, 1.0f)));
+}
+
+// std140 uniform block shared by all skinned draws, bound to BONE_PALETTE_BINDING
+const GLuint BONE_PALETTE_BINDING = 0;
+
+class BonePaletteBuffer {
+public:
+    GLuint UBO;
+
+    BonePaletteBuffer() {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_BONES * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+        MemoryTracker::instance().gpuAllocated(MEM_ANIMATION, GPU_BUFFER, UBO, MAX_BONES * sizeof(glm::mat4));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, BONE_PALETTE_BINDING, UBO);
+    }
+
+    void upload(const std::vector<glm::mat4> &palette) {
+        size_t count = std::min(palette.size(), (size_t)MAX_BONES);
+        if (count == 0)
+            return;
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, count * sizeof(glm::mat4), palette.data());
+        RenderStats::instance().bufferUpload(count * sizeof(glm::mat4));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void destroy() {
+        MemoryTracker::instance().gpuFreed(GPU_BUFFER, UBO);
+        glDeleteBuffers(1, &UBO);
+    }
+};
+
+#endif // SKELETON_HPP_
@@ -0,0 +1,65 @@
+#ifndef TEXTURE_HPP_
+#define TEXTURE_HPP_
+#include "./profiler.hpp"
+
+// Texture loading in two halves, so decoding can run on job threads.
+// Needs stb_image.h included first (the implementation lives in main.cpp).
+
+struct DecodedImage {
+    unsigned char* data;
+    int width, height, nrChannels;
+};
+
+// CPU-only, safe to run on job threads
+DecodedImage decodeImage(const char* path) {
+    PROFILE_ZONE("decodeImage");
+    DecodedImage image;
+    image.data = stbi_load(path, &image.width, &image.height, &image.nrChannels, 0);
+    return image;
+}
+
+// Main thread only, frees the decoded pixels
+GLuint uploadTexture(DecodedImage image, const char* path) {
+    PROFILE_ZONE("uploadTexture");
+    unsigned char* data = image.data;
+    int width = image.width, height = image.height, nrChannels = image.nrChannels;
+    if (!data) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return 0;
+    }
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    GLenum format;
+    if (nrChannels == 1)
+        format = GL_RED;
+    else if (nrChannels == 3)
+        format = GL_RGB;
+    else if (nrChannels == 4)
+        format = GL_RGBA;
+
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    RenderStats::instance().textureBind();
+    RenderStats::instance().textureUpload((size_t)width * height * nrChannels);
+    // Drivers pad RGB to four bytes; the mip chain adds a third
+    MemoryTracker::instance().gpuAllocated(MEM_IMAGES, GPU_TEXTURE, textureID, (size_t)width * height * 4 * 4 / 3);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    stbi_image_free(data);
+    std::cout << "Loaded texture: " << path << " with ID: " << textureID << std::endl;
+    return textureID;
+}
+
+GLuint loadTexture(const char* path) {
+    PROFILE_ZONE("loadTexture");
+    return uploadTexture(decodeImage(path), path);
+}
+
+#endif // TEXTURE_HPP_
@@ -0,0 +1,121 @@
+#ifndef TRACE_EXPORT_HPP_
+#define TRACE_EXPORT_HPP_
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "./profiler.hpp"
+
+// Chrome Trace Event export (chrome://tracing, ui.perfetto.dev).
+// start() arms a capture of the next N frames; update(), called by the main thread right
+// after Profiler::frameMark(), moves every zone that ended since the previous call out of
+// the thread rings, so nothing is lost to ring wrap-around however long the capture.
+// CPU threads are pid 1, GPU passes pid 2 on the same clock, counters are "C" events.
+
+class TraceCapture {
+public:
+    TraceCapture() : framesLeft(0), cursor(0) {}
+
+    bool active() const { return framesLeft > 0; }
+
+    // fromStartup: also take everything recorded before the first frame (model and texture loading)
+    void start(int frames, const std::string &outputPath, bool fromStartup = false) {
+        if (active() || frames <= 0)
+            return;
+        framesLeft = frames;
+        path = outputPath;
+        cursor = fromStartup ? 0 : profileNow();
+        events.clear();
+        Profiler::instance().beginCapture();
+    }
+
+    void update() {
+        if (!active())
+            return;
+        MemoryScope memory(MEM_PROFILER);
+        int64_t now = profileNow();
+        std::vector<std::vector<ProfileEvent>> frame;
+        Profiler::instance().collect(cursor, now, threadNames, frame);
+        events.resize(frame.size());
+        for (size_t t = 0; t < frame.size(); t++)
+            for (const ProfileEvent &event : frame[t])
+                if (event.end >= cursor && event.end < now) // each zone belongs to the call its end falls in
+                    events[t].push_back(event);
+        cursor = now;
+        if (--framesLeft == 0)
+            write();
+    }
+
+private:
+    int framesLeft;
+    std::string path;
+    int64_t cursor;
+    std::vector<std::string> threadNames;
+    std::vector<std::vector<ProfileEvent>> events;
+
+    static std::string escape(const std::string &text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+    // Microseconds, which is what the format wants
+    static void timestamp(std::ofstream &file, int64_t ns) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", ns / 1000.0);
+        file << buffer;
+    }
+
+    void write() {
+        std::vector<GpuScopeTiming> gpu;
+        std::vector<ProfileCounterSample> counters;
+        Profiler::instance().endCapture(gpu, counters);
+
+        std::ofstream file(path);
+        if (!file) {
+            std::cerr << "ERROR::TRACE::CANNOT_WRITE " << path << std::endl;
+            return;
+        }
+        size_t written = 0;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":2,\"args\":{\"name\":\"GPU\"}},\n";
+        file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"Render passes\"}}";
+        for (size_t t = 0; t < threadNames.size(); t++)
+            file << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << t << ",\"args\":{\"name\":\"" << escape(threadNames[t]) << "\"}}";
+
+        for (size_t t = 0; t < events.size(); t++) {
+            for (const ProfileEvent &event : events[t]) {
+                file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << t << ",\"name\":\"" << escape(event.zone->name) << "\",\"ts\":";
+                timestamp(file, event.begin);
+                file << ",\"dur\":";
+                timestamp(file, event.end - event.begin);
+                file << "}";
+                written++;
+            }
+        }
+        for (const GpuScopeTiming &timing : gpu) {
+            file << ",\n{\"ph\":\"X\",\"pid\":2,\"tid\":0,\"name\":\"" << escape(timing.zone->name) << "\",\"ts\":";
+            timestamp(file, timing.begin);
+            file << ",\"dur\":";
+            timestamp(file, timing.end - timing.begin);
+            file << "}";
+            written++;
+        }
+        for (const ProfileCounterSample &sample : counters) {
+            file << ",\n{\"ph\":\"C\",\"pid\":1,\"name\":\"" << escape(sample.name) << "\",\"ts\":";
+            timestamp(file, sample.time);
+            file << ",\"args\":{\"value\":" << sample.value << "}}";
+            written++;
+        }
+        file << "\n]}\n";
+        std::cout << "Trace written: " << path << " (" << written << " events)" << std::endl;
+        events.clear();
+    }
+};
+
+#endif // TRACE_EXPORT_HPP_
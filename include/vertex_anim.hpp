@@ -0,0 +1,160 @@
+#ifndef VERTEX_ANIM_HPP_
+#define VERTEX_ANIM_HPP_
+#include "./animation.hpp"
+
+// Vertex animation textures for crowds.
+// Every clip is baked offline-style into one RGBA32F texture holding the bone palette
+// of each frame: a row per frame, three texels per bone (the rows of the 3x4 affine part).
+// Instanced draws fetch the palette in the vertex shader from a per-instance clip and
+// time offset, so distant characters cost no pose evaluation or CPU skinning at all.
+
+struct BakedClipRange {
+    std::string name;
+    int firstFrame; // row in the texture
+    int frameCount;
+    float duration;
+};
+
+class BakedAnimationTexture {
+public:
+    GLuint texture;
+    int boneCount;
+    int frameCount; // rows, all clips stacked
+    float sampleRate;
+    std::vector<BakedClipRange> clips;
+
+    BakedAnimationTexture() : texture(0), boneCount(0), frameCount(0), sampleRate(0.0f) {}
+
+    bool empty() const { return texture == 0; }
+
+    void bake(const Skeleton &skeleton, const std::vector<AnimationClip> &animations, float rate = 30.0f) {
+        destroy();
+        clips.clear();
+        boneCount = (int)skeleton.inverseBind.size();
+        sampleRate = rate;
+        frameCount = 0;
+        if (boneCount == 0 || animations.empty())
+            return;
+
+        int width = boneCount * 3;
+        GLint maxSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        if (width > maxSize) {
+            std::cerr << "ERROR::VERTEX_ANIM::" << boneCount << " bones do not fit in a texture row" << std::endl;
+            return;
+        }
+
+        std::vector<float> texels;
+        PoseSoA pose((int)skeleton.joints.size());
+        std::vector<glm::mat4> modelSpace, palette;
+        for (const AnimationClip &clip : animations) {
+            SampledClip sampled = SampledClip::fromClip(skeleton, clip, rate);
+            int rows = std::min(sampled.frameCount, maxSize - frameCount);
+            if (rows < 2)
+                break;
+            clips.push_back({ clip.name, frameCount, rows, clip.duration });
+            for (int f = 0; f < rows; f++) {
+                sampleClip(sampled, f / rate, pose);
+                poseToPalette(skeleton, pose, modelSpace, palette);
+                for (const glm::mat4 &m : palette)
+                    for (int r = 0; r < 3; r++)
+                        texels.insert(texels.end(), { m[0][r], m[1][r], m[2][r], m[3][r] });
+            }
+            frameCount += rows;
+        }
+        if (frameCount == 0)
+            return;
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, frameCount, 0, GL_RGBA, GL_FLOAT, texels.data());
+        RenderStats::instance().textureUpload(texels.size() * sizeof(texels[0]));
+        MemoryTracker::instance().gpuAllocated(MEM_ANIMATION, GPU_TEXTURE, texture, texels.size() * sizeof(texels[0]));
+        // Fetched with texelFetch only
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        std::cout << "Baked " << clips.size() << " clips into a " << width << "x" << frameCount << " animation texture" << std::endl;
+    }
+
+    void destroy() {
+        if (texture) {
+            MemoryTracker::instance().gpuFreed(GPU_TEXTURE, texture);
+            glDeleteTextures(1, &texture);
+        }
+        texture = 0;
+    }
+};
+
+// Per-instance data, attribute locations 5 and 6 of the crowd shader
+struct CrowdInstance {
+    glm::vec4 placement; // xyz position, w yaw in radians
+    glm::vec4 animation; // x first frame, y frame count, z time offset in seconds, w playback speed
+};
+
+// Own VAO over a Mesh's vertex and index buffers plus an instance buffer, so the mesh's
+// VAO never sees instanced arrays; draws the whole crowd with one call
+class CrowdRenderer {
+public:
+    GLuint VAO;
+    GLuint instanceVBO;
+    std::vector<CrowdInstance> instances;
+
+    CrowdRenderer(Mesh &m) : mesh(m) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &instanceVBO);
+        glBindVertexArray(VAO);
+        mesh.bindVertexAttributes();
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)offsetof(CrowdInstance, placement));
+        glEnableVertexAttribArray(5);
+        glVertexAttribDivisor(5, 1);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(CrowdInstance), (void*)offsetof(CrowdInstance, animation));
+        glEnableVertexAttribArray(6);
+        glVertexAttribDivisor(6, 1);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void add(glm::vec3 position, float yaw, const BakedClipRange &clip, float timeOffset, float speed = 1.0f) {
+        instances.push_back({ glm::vec4(position, yaw), glm::vec4((float)clip.firstFrame, (float)clip.frameCount, timeOffset, speed) });
+    }
+
+    // Call after adding or moving instances
+    void upload() {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CrowdInstance), instances.data(), GL_DYNAMIC_DRAW);
+        RenderStats::instance().bufferUpload(instances.size() * sizeof(CrowdInstance));
+        MemoryTracker::instance().gpuAllocated(MEM_ANIMATION, GPU_BUFFER, instanceVBO, instances.size() * sizeof(CrowdInstance));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void draw(Shader &shader, const BakedAnimationTexture &baked, float time, GLenum unit = GL_TEXTURE3) {
+        if (instances.empty() || baked.empty())
+            return;
+        glActiveTexture(unit);
+        glBindTexture(GL_TEXTURE_2D, baked.texture);
+        RenderStats::instance().textureBind();
+        shader.setInt("animationTexture", (int)(unit - GL_TEXTURE0));
+        shader.setFloat("animationTime", time);
+        shader.setFloat("animationSampleRate", baked.sampleRate);
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)mesh.indices.size(), GL_UNSIGNED_INT, 0, (GLsizei)instances.size());
+        RenderStats::instance().vertexArrayBind();
+        RenderStats::instance().draw(GL_TRIANGLES, (GLsizei)mesh.indices.size(), (GLsizei)instances.size());
+        glBindVertexArray(0);
+    }
+
+    void destroy() {
+        MemoryTracker::instance().gpuFreed(GPU_BUFFER, instanceVBO);
+        glDeleteBuffers(1, &instanceVBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+private:
+    Mesh &mesh;
+};
+
+#endif // VERTEX_ANIM_HPP_
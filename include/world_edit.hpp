@@ -0,0 +1,105 @@
+#ifndef WORLD_EDIT_HPP_
+#define WORLD_EDIT_HPP_
+#include "./light.hpp"
+
+struct BlockEdit {
+    glm::ivec3 pos;
+    uint16_t block;
+};
+
+// Bulk block edits for players, explosions, generators and scripts.
+// Edits are written straight into the chunks' palette storage and only queue
+// light work and dirty regions; flush() runs a single light propagation per frame
+// and WorldRenderer::update remeshes each touched chunk once, no matter how many
+// blocks changed.
+class WorldEditor {
+public:
+    World &world;
+    LightEngine &lightEngine;
+    int editsLastFrame;  // blocks actually changed in the last flushed frame
+    int pendingEdits;
+
+    WorldEditor(World &w, LightEngine &light) : world(w), lightEngine(light), editsLastFrame(0), pendingEdits(0) {}
+
+    void setBlock(glm::ivec3 p, uint16_t block) {
+        int i;
+        Chunk* chunk = world.locate(p, i);
+        if (chunk)
+            write(*chunk, i, p, block);
+    }
+
+    // Inclusive box
+    void fillBox(glm::ivec3 from, glm::ivec3 to, uint16_t block) {
+        forEachInBox(from, to, [&](Chunk &chunk, int i, glm::ivec3 p) {
+            write(chunk, i, p, block);
+        });
+    }
+
+    void fillSphere(glm::ivec3 center, int radius, uint16_t block) {
+        glm::ivec3 r(radius, radius, radius);
+        int radiusSq = radius * radius;
+        forEachInBox(center - r, center + r, [&](Chunk &chunk, int i, glm::ivec3 p) {
+            glm::ivec3 d = p - center;
+            if (d.x * d.x + d.y * d.y + d.z * d.z <= radiusSq)
+                write(chunk, i, p, block);
+        });
+    }
+
+    // Swaps every `from` block inside the inclusive box for `to`
+    void replace(glm::ivec3 from, glm::ivec3 to, uint16_t oldBlock, uint16_t newBlock) {
+        forEachInBox(from, to, [&](Chunk &chunk, int i, glm::ivec3 p) {
+            if (chunk.blocks.get(i) == oldBlock)
+                write(chunk, i, p, newBlock);
+        });
+    }
+
+    void apply(const std::vector<BlockEdit> &edits) {
+        for (const BlockEdit &edit : edits)
+            setBlock(edit.pos, edit.block);
+    }
+
+    // Call once per frame, before WorldRenderer::update
+    void flush() {
+        editsLastFrame = pendingEdits;
+        pendingEdits = 0;
+        if (editsLastFrame > 0)
+            lightEngine.propagate();
+    }
+
+private:
+    void write(Chunk &chunk, int i, glm::ivec3 p, uint16_t block) {
+        uint16_t old = chunk.blocks.get(i);
+        if (old == block)
+            return;
+        chunk.blocks.set(i, block);
+        lightEngine.onBlockChanged(p, old, block);
+        pendingEdits++;
+    }
+
+    // Visits the box clamped to the world, chunk by chunk, so each chunk is resolved once
+    template <typename Fn>
+    void forEachInBox(glm::ivec3 from, glm::ivec3 to, Fn fn) {
+        glm::ivec3 worldMax = world.size * CHUNK_SIZE - glm::ivec3(1, 1, 1);
+        from = glm::max(from, glm::ivec3(0, 0, 0));
+        to = glm::min(to, worldMax);
+        if (from.x > to.x || from.y > to.y || from.z > to.z)
+            return;
+        glm::ivec3 c0 = from / CHUNK_SIZE, c1 = to / CHUNK_SIZE;
+        for (int cy = c0.y; cy <= c1.y; cy++) {
+            for (int cz = c0.z; cz <= c1.z; cz++) {
+                for (int cx = c0.x; cx <= c1.x; cx++) {
+                    Chunk* chunk = world.getChunk(glm::ivec3(cx, cy, cz));
+                    glm::ivec3 base = chunk->coord * CHUNK_SIZE;
+                    glm::ivec3 lo = glm::max(from, base) - base;
+                    glm::ivec3 hi = glm::min(to, base + glm::ivec3(CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1)) - base;
+                    for (int y = lo.y; y <= hi.y; y++)
+                        for (int z = lo.z; z <= hi.z; z++)
+                            for (int x = lo.x; x <= hi.x; x++)
+                                fn(*chunk, Chunk::index(x, y, z), base + glm::ivec3(x, y, z));
+                }
+            }
+        }
+    }
+};
+
+#endif // WORLD_EDIT_HPP_
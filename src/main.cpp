@@ -11,13 +11,38 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#define MEMORY_TRACKER_IMPLEMENTATION
+#include "../include/memory_tracker.hpp"
+#define STBI_MALLOC(size) memoryAllocate(size, MEM_IMAGES)
+#define STBI_REALLOC(pointer, size) memoryReallocate(pointer, size, MEM_IMAGES)
+#define STBI_FREE(pointer) memoryFree(pointer)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "../include/shader.hpp"
+#include "../include/profiler.hpp"
+#include "../include/texture.hpp"
 
 #include "../include/cube.hpp"
 #include "../include/plane.hpp"
 #include "../include/mesh.hpp"
+#include "../include/anim_runtime.hpp"
+#include "../include/vertex_anim.hpp"
+#include "../include/chunk.hpp"
+#include "../include/light.hpp"
+#include "../include/chunk_mesh.hpp"
+#include "../include/world_edit.hpp"
+#include "../include/fixed_timestep.hpp"
+#include "../include/frame_pipeline.hpp"
+#include "../include/presenter.hpp"
+#include "../include/input.hpp"
+#include "../include/input_recording.hpp"
+#include "../include/camera_buffer.hpp"
+#include "../include/dynamic_resolution.hpp"
+#include "../include/render_graph.hpp"
+#include "../include/trace_export.hpp"
+#include "../include/camera_path.hpp"
+#include "../include/benchmark.hpp"
+#include "../include/headless.hpp"
 
 enum Camera_Movement {
     FORWARD,
@@ -29,6 +54,7 @@ enum Camera_Movement {
 class Camera {
 public:
     glm::vec3 Position;
+    glm::vec3 PreviousPosition; // position at the previous simulation tick
     glm::vec3 Front;
     glm::vec3 Up;
     glm::vec3 Right;
@@ -42,8 +68,9 @@ public:
     float Zoom;
 
     Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = -90.1f, float pitch = -28.3f)
-        : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(2.5f), MouseSensitivity(0.1f), Zoom(45.0f) {
+        : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(7.5f), MouseSensitivity(0.1f), Zoom(45.0f) {
         Position = position;
+        PreviousPosition = position;
         WorldUp = up;
         Yaw = yaw;
         Pitch = pitch;
@@ -54,6 +81,12 @@ public:
         return glm::lookAt(Position, Position + Front, Up);
     }
 
+    // View from the position blended between the last two simulation ticks
+    glm::mat4 GetViewMatrix(float alpha) {
+        glm::vec3 eye = glm::mix(PreviousPosition, Position, alpha);
+        return glm::lookAt(eye, eye + Front, Up);
+    }
+
     void ProcessKeyboard(Camera_Movement direction, float deltaTime) {
         float velocity = MovementSpeed * deltaTime;
         if (direction == FORWARD)
@@ -82,6 +115,12 @@ public:
         updateCameraVectors();
     }
 
+    void SetOrientation(float yaw, float pitch) {
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    }
+
     void ProcessMouseScroll(float yoffset) {
         Zoom -= (float)yoffset;
         if (Zoom < 1.0f)
@@ -106,73 +145,95 @@ private:
 // Global camera object
 Camera camera(glm::vec3(0.0f, 9.84f, 14.36f));
 
+// Framebuffer size, read into every frame snapshot; the render thread sets the viewport
+int framebufferWidth = 800, framebufferHeight = 600;
+
 // Callback function for framebuffer resize
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    framebufferWidth = width;
+    framebufferHeight = height;
 }
 
-// Callback function for mouse movement
-void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
-    static float lastX = 400, lastY = 300;
-    static bool firstMouse = true;
+// Everything the render thread needs to draw one frame, filled by the main thread
+struct FrameSnapshot {
+    float alpha;        // between the last two simulation ticks
+    float timeOfDay;    // already interpolated
+    float time;         // seconds, drives the instanced crowd
+    int framebufferWidth, framebufferHeight;
+    std::vector<Cube> cubes; // copies, the simulation keeps ticking the originals
+    std::vector<glm::mat4> humanPalette, wolfPalette;
+    bool showWolfPack;
+    std::vector<ChunkMeshUpload> chunkUploads;
+    UiSnapshot ui;
+};
 
-    if (firstMouse) {
-        lastX = xpos;
-        lastY = ypos;
-        firstMouse = false;
+int main(int argc, char** argv) {
+    // --trace <frames> [--trace-file <path>]: capture the startup and the first frames
+    // --benchmark [frames] [--benchmark-report <path>] [--camera-path <path>]: headless run
+    // --record <path>: record the session's input; --replay <path>: play one back, windowed
+    // or, with --benchmark, headless for the recording's length
+    int traceFrames = 300;
+    std::string tracePath = "trace.json";
+    bool traceAtStartup = false;
+    Benchmark benchmark;
+    std::string cameraPathFile = "camera_path.txt";
+    bool cameraPathGiven = false;
+    std::string recordPath, replayPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc) {
+            traceFrames = std::atoi(argv[++i]);
+            traceAtStartup = true;
+        } else if (arg == "--trace-file" && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (arg == "--benchmark") {
+            benchmark.frames = 1000;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                benchmark.frames = std::atoi(argv[++i]);
+        } else if (arg == "--benchmark-report" && i + 1 < argc) {
+            benchmark.reportPath = argv[++i];
+        } else if (arg == "--camera-path" && i + 1 < argc) {
+            cameraPathFile = argv[++i];
+            cameraPathGiven = true;
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        }
     }
-
-    float xoffset = xpos - lastX;
-    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
-
-    lastX = xpos;
-    lastY = ypos;
-
-    // Check if the left mouse button is pressed
-    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-        camera.ProcessMouseMovement(xoffset, yoffset);
+    InputReplay replay;
+    if (!replayPath.empty()) {
+        if (!replay.load(replayPath))
+            return -1;
+        // A benchmark of a replay runs exactly the recorded frames
+        if (benchmark.active()) {
+            benchmark.warmupFrames = std::min(benchmark.warmupFrames, (int)replay.frames.size() / 2);
+            benchmark.frames = std::max((int)replay.frames.size() - benchmark.warmupFrames, 1);
+        }
     }
-}
-
-// Callback function for mouse scroll
-void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-    camera.ProcessMouseScroll(yoffset);
-}
-
-GLuint loadTexture(const char* path) {
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (!data) {
-        std::cerr << "Failed to load texture: " << path << std::endl;
-        return 0;
+    bool headless = benchmark.active();
+    const int benchmarkWidth = 1280, benchmarkHeight = 720;
+
+    // Benchmark fly-through, a loop over the scene unless a recorded path is given
+    CameraPath cameraPath;
+    if (!cameraPathGiven || !cameraPath.load(cameraPathFile)) {
+        cameraPath.keys = {
+            { glm::vec3(0.0f, 9.84f, 14.36f), -90.1f, -28.3f },
+            { glm::vec3(9.0f, 5.0f, 6.0f), -135.0f, -20.0f },
+            { glm::vec3(12.0f, 14.0f, -18.0f), -160.0f, -30.0f },
+            { glm::vec3(-4.0f, 22.0f, -40.0f), -250.0f, -35.0f },
+            { glm::vec3(-14.0f, 8.0f, -6.0f), -320.0f, -15.0f },
+            { glm::vec3(0.0f, 9.84f, 14.36f), -450.1f, -28.3f }
+        };
     }
+    TraceCapture traceCapture;
+    if (traceAtStartup)
+        traceCapture.start(traceFrames, tracePath, true);
 
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    GLenum format;
-    if (nrChannels == 1)
-        format = GL_RED;
-    else if (nrChannels == 3)
-        format = GL_RGB;
-    else if (nrChannels == 4)
-        format = GL_RGBA;
-
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-    std::cout << "Loaded texture: " << path << " with ID: " << textureID << std::endl;
-    return textureID;
-}
+    // Headless: no display needed
+    if (headless)
+        headlessPlatformHint();
 
-int main() {
     // Инициализация GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -185,7 +246,8 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     // Создание окна
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Cube with Checkerboard Pattern", nullptr, nullptr);
+    GLFWwindow* window = headless ? createHeadlessWindow(benchmarkWidth, benchmarkHeight, "Benchmark")
+                                  : glfwCreateWindow(800, 600, "Cube with Checkerboard Pattern", nullptr, nullptr);
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -197,18 +259,24 @@ int main() {
 
     // Установка callback для изменения размера окна
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
+
+    // Keyboard and mouse go through the timestamped event queue
+    InputSystem input;
+    input.install(window);
+    input.live = !replay.loaded();
+    bool mouseLook = false;    // left button held outside the UI
+    bool rawMouseMotion = true;
 
     // Инициализация GLEW
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
+    if ((headless ? headlessGlewInit() : glewInit()) != GLEW_OK) {
         std::cerr << "Failed to initialize GLEW" << std::endl;
         return -1;
     }
 
     // Инициализация ImGui
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(imguiAllocate, imguiFree);
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     ImGui::StyleColorsDark();
@@ -237,8 +305,8 @@ int main() {
     style.WindowRounding = 5.0f; // Rounded corners
     style.WindowBorderSize = 1.0f; // Border size
 
-    // Установка viewport
-    glViewport(0, 0, 800, 600);
+    // The viewport follows the framebuffer every frame; start from its real size (HiDPI)
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
 
     // Установка цвета фона
     glClearColor(91.0f / 255.0f, 119.0f / 255.0f, 225.0f / 255.0f, 1.0f);
@@ -258,6 +326,35 @@ int main() {
     Shader outlineShader(vertexShaderSource, outlineFragmentShaderSource);
     Shader modelShader(modelVertexShaderSource, modelFragmentShaderSource);
     Shader modelOutlineShader(modelOutlineVertexShaderSource, modelOutlineFragmentShaderSource);
+    Shader chunkShader(chunkVertexShaderSource, chunkFragmentShaderSource);
+    for (Shader* program : { &shader, &outlineShader, &modelShader, &modelOutlineShader, &chunkShader })
+        program->bindUniformBlock("Camera", CAMERA_BINDING);
+    CameraBuffer cameraBuffer;
+
+    // The 3D passes render at a scale that keeps their GPU time within budget
+    Shader upscaleShader(upscaleVertexShaderSource, upscaleFragmentShaderSource);
+    DynamicResolution dynamicResolution(upscaleShader);
+    RenderGraph renderGraph;
+    GpuTimers gpuTimers; // per pass, feeds the profiler and the resolution scale
+    renderGraph.gpuTimers = &gpuTimers;
+
+    // Without a window surface the frame ends in an offscreen target; the scene renders
+    // at a fixed resolution so runs compare
+    GLuint headlessFBO = 0, headlessColor = 0;
+    std::string rendererName = (const char*)glGetString(GL_RENDERER);
+    if (headless) {
+        glGenRenderbuffers(1, &headlessColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, headlessColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, framebufferWidth, framebufferHeight);
+        MemoryTracker::instance().gpuAllocated(MEM_RENDERER, GPU_RENDERBUFFER, headlessColor, (size_t)framebufferWidth * framebufferHeight * 4);
+        glGenFramebuffers(1, &headlessFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, headlessFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headlessColor);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        renderGraph.backbufferFramebuffer = headlessFBO;
+        dynamicResolution.enabled = false;
+        std::cout << "Benchmark: " << benchmark.frames << " frames on " << rendererName << std::endl;
+    }
     // Создание кубов
     std::vector<Cube> cubes = {
         Cube(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f), 1),
@@ -267,160 +364,486 @@ int main() {
     // Создание плоскости
     Plane plane(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(10.0f, 1.0f, 10.0f), 0);
 
+    // Worker threads for animation, meshing and decoding; the main thread joins in while it waits
+    JobSystem jobSystem;
+
+    // Voxel terrain behind the plane
+    World world(glm::ivec3(4, 2, 4), glm::ivec3(-32, -17, -70));
+    LightEngine lightEngine(world);
+    {
+        MemoryScope memory(MEM_WORLD);
+        generateTerrain(world);
+        lightEngine.lightWorld();
+    }
+    WorldEditor worldEditor(world, lightEngine);
+    WorldRenderer worldRenderer(world, jobSystem);
+    glm::ivec3 lampPos(32, 14, 40);
+    bool lampPlaced = false;
+
     Mesh humanModel = loadModel("../Assets/rigged_human.obj");
     std::cout << "Model loaded!" << std::endl;
     Mesh wolfModel = loadModel("../Assets/Objects/wolf/obj/Wolf_obj.obj");
     std::cout << "Model loaded!" << std::endl;
 
-    // Load textures for the wolf model
-    GLuint wolfBodyTexture = loadTexture("../Assets/Objects/wolf/obj/textures/Wolf_Body.jpg");
-    GLuint wolfEyesTexture = loadTexture("../Assets/Objects/wolf/obj/textures/Wolf_Eyes_2.jpg");
-    GLuint wolfFurTexture = loadTexture("../Assets/Objects/wolf/obj/textures/Wolf_Fur.jpg");
-
-    // Load texture for the plane
-    GLuint planeTexture = loadTexture("../Assets/skin_texture.jpg");
+    // GPU skinning for models that come with a skeleton
+    Shader skinnedModelShader(skinnedModelVertexShaderSource, modelFragmentShaderSource);
+    skinnedModelShader.bindUniformBlock("BonePalette", BONE_PALETTE_BINDING);
+    skinnedModelShader.bindUniformBlock("Camera", CAMERA_BINDING);
+    BonePaletteBuffer bonePalette;
+
+    // Clips are compressed once after import, the runtime decodes them directly
+    std::vector<CompressedClip> humanClips, wolfClips;
+    {
+        MemoryScope memory(MEM_ANIMATION);
+        for (const AnimationClip &clip : humanModel.animations)
+            humanClips.push_back(compressClip(humanModel.skeleton, clip));
+        for (const AnimationClip &clip : wolfModel.animations)
+            wolfClips.push_back(compressClip(wolfModel.skeleton, clip));
+    }
+    for (size_t i = 0; i < humanClips.size(); i++)
+        std::cout << "Compressed clip " << humanClips[i].name << ": " << rawClipBytes(humanModel.animations[i]) << " -> " << humanClips[i].sizeBytes() << " bytes" << std::endl;
+    for (size_t i = 0; i < wolfClips.size(); i++)
+        std::cout << "Compressed clip " << wolfClips[i].name << ": " << rawClipBytes(wolfModel.animations[i]) << " -> " << wolfClips[i].sizeBytes() << " bytes" << std::endl;
+
+    AnimationRuntime animationRuntime(jobSystem);
+    int humanCharacter = humanClips.empty() ? -1 : animationRuntime.addCharacter(humanModel.skeleton, humanClips[0]);
+    int wolfCharacter = wolfClips.empty() ? -1 : animationRuntime.addCharacter(wolfModel.skeleton, wolfClips[0]);
+    if (humanCharacter >= 0)
+        animationRuntime.characters[humanCharacter].position = glm::vec3(-1.0f, -1.0f, 0.0f);
+    if (wolfCharacter >= 0)
+        animationRuntime.characters[wolfCharacter].position = glm::vec3(-1.5f, -1.0f, 0.0f);
+
+    // Distant wolf pack: baked bone palettes, one instanced draw, no pose evaluation
+    Shader crowdShader(crowdVertexShaderSource, modelFragmentShaderSource);
+    crowdShader.bindUniformBlock("Camera", CAMERA_BINDING);
+    BakedAnimationTexture wolfBaked;
+    {
+        MemoryScope memory(MEM_ANIMATION);
+        wolfBaked.bake(wolfModel.skeleton, wolfModel.animations);
+    }
+    CrowdRenderer wolfPack(wolfModel);
+    if (!wolfBaked.empty()) {
+        MemoryScope memory(MEM_ANIMATION);
+        for (int i = 0; i < 256; i++) {
+            glm::vec3 position(-24.0f + (i % 16) * 3.0f, -1.0f, -30.0f - (i / 16) * 3.0f);
+            const BakedClipRange &clip = wolfBaked.clips[i % wolfBaked.clips.size()];
+            wolfPack.add(position, (i * 37 % 360) * 0.0174533f, clip, (i * 0.173f), 0.8f + (i % 5) * 0.1f);
+        }
+        wolfPack.upload();
+    }
+    bool showWolfPack = true;
+
+    // Textures for the wolf model and the plane: decoded on the job threads, uploaded here
+    const char* texturePaths[4] = {
+        "../Assets/Objects/wolf/obj/textures/Wolf_Body.jpg",
+        "../Assets/Objects/wolf/obj/textures/Wolf_Eyes_2.jpg",
+        "../Assets/Objects/wolf/obj/textures/Wolf_Fur.jpg",
+        "../Assets/skin_texture.jpg"
+    };
+    GLuint textures[4] = { 0, 0, 0, 0 };
+    jobSystem.parallel_for(4, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            DecodedImage image = decodeImage(texturePaths[i]);
+            jobSystem.runOnGLThread([&textures, &texturePaths, image, i] { textures[i] = uploadTexture(image, texturePaths[i]); });
+        }
+    });
+    jobSystem.drainGLThread();
+    GLuint wolfBodyTexture = textures[0];
+    GLuint wolfEyesTexture = textures[1];
+    GLuint wolfFurTexture = textures[2];
+    GLuint planeTexture = textures[3];
 
     // Time of day variable
     float timeOfDay = 0.5f; // 0.0 for night, 1.0 for day
+    float previousTimeOfDay = timeOfDay;
     float timeSpeed = 0.01f; // Speed of time change
 
-    // Основной цикл
-    while (!glfwWindowShouldClose(window)) {
-        // Обработка ввода
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-            glfwSetWindowShouldClose(window, true);
-
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-            camera.ProcessKeyboard(FORWARD, 0.05f);
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            camera.ProcessKeyboard(BACKWARD, 0.05f);
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-            camera.ProcessKeyboard(LEFT, 0.05f);
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-            camera.ProcessKeyboard(RIGHT, 0.05f);
-
-        // Add arrow key controls
-        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
-            camera.ProcessKeyboard(FORWARD, 0.05f);
-        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
-            camera.ProcessKeyboard(BACKWARD, 0.05f);
-        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)
-            camera.ProcessKeyboard(LEFT, 0.05f);
-        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)
-            camera.ProcessKeyboard(RIGHT, 0.05f);
-
-        // Update time of day
-        timeOfDay += timeSpeed * ImGui::GetIO().DeltaTime;
-        if (timeOfDay > 1.0f)
-            timeOfDay = 0.0f;
-
-        // Рендеринг
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-        // Установка матриц
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 800.0f / 600.0f, 0.1f, 100.0f);
-
-        /// HUMAN MODEL
-        modelShader.use();
-        modelShader.setMat4("view", view);
-        modelShader.setMat4("projection", projection);
-        glm::mat4 model = glm::mat4(1.0f); // Identity matrix for the model
-        model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f)); // FIXME: scale factor = ...
-        modelShader.setMat4("model", model);
-        humanModel.Draw(modelShader);
-        // HUMAN MODEL
-
-        /// WOLF MODEL
-        // In the rendering loop
-        modelShader.use();
-        modelShader.setMat4("view", view);
-        modelShader.setMat4("projection", projection);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, wolfBodyTexture);
-        modelShader.setInt("bodyTexture", 0);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, wolfEyesTexture);
-        modelShader.setInt("eyesTexture", 1);
-
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, wolfFurTexture);
-        modelShader.setInt("furTexture", 2);
-
-        glm::mat4 wmodel = glm::mat4(1.0f); // Identity matrix for the model
-        wmodel = glm::translate(wmodel, glm::vec3(-1.5f, -1.0f, 0.0f));
-        wmodel = glm::scale(wmodel, glm::vec3(1.0f, 1.0f, 1.0f)); // FIXME: scale factor = ...
-        modelShader.setMat4("model", wmodel);
-        wolfModel.Draw(modelShader);
-
-        // WOLF MODEL
-
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-
-        outlineShader.use();
-        outlineShader.setMat4("view", view);
-        outlineShader.setMat4("projection", projection);
-
-        // Рисование кубов
-        for (auto& cube : cubes) {
-            // Рисование куба в буфер трафарета
+    // Camera, cube spin and time of day tick at 60 Hz whatever the frame rate
+    FixedTimestep simClock(1.0 / 60.0);
+    TickInput tickInput;
+
+    // Settings changed from the UI go through UiActions, so recordings can store them
+    auto applyUiAction = [&](const UiAction &action) {
+        switch (action.type) {
+        case UI_TIME_OF_DAY:
+            timeOfDay = previousTimeOfDay = action.value;
+            break;
+        case UI_LAMP:
+            lampPlaced = action.value != 0.0f;
+            worldEditor.setBlock(lampPos, lampPlaced ? BLOCK_LAMP : BLOCK_AIR);
+            break;
+        case UI_CRATER:
+            worldEditor.fillSphere(lampPos - glm::ivec3(0, 4, 0), 6, BLOCK_AIR);
+            break;
+        case UI_WALL:
+            worldEditor.fillBox(lampPos + glm::ivec3(-12, -4, -8), lampPos + glm::ivec3(12, 4, -7), BLOCK_STONE);
+            break;
+        case UI_WOLF_PACK:
+            showWolfPack = action.value != 0.0f;
+            break;
+        case UI_ANIMATION_LOD:
+            animationRuntime.lodSettings.enabled = action.value != 0.0f;
+            break;
+        }
+    };
+
+    // Input recording and replay start from the same scene
+    InputRecorder recorder;
+    RecordedFrame recordedFrame;
+    std::vector<UiAction> uiActions;
+    if (replay.loaded()) {
+        const RecordedScene &scene = replay.scene;
+        simClock.step = replay.step;
+        camera.PreviousPosition = camera.Position = scene.cameraPosition;
+        camera.SetOrientation(scene.cameraYaw, scene.cameraPitch);
+        camera.Zoom = scene.cameraZoom;
+        timeOfDay = previousTimeOfDay = scene.timeOfDay;
+        timeSpeed = scene.timeSpeed;
+        if (scene.lampPlaced)
+            applyUiAction({ UI_LAMP, 1.0f });
+        showWolfPack = scene.showWolfPack;
+        animationRuntime.lodSettings.enabled = scene.animationLod;
+        std::cout << "Replaying " << replayPath << ": " << replay.frames.size() << " frames" << std::endl;
+    } else if (!recordPath.empty()) {
+        RecordedScene scene = { camera.Position, camera.Yaw, camera.Pitch, camera.Zoom, timeOfDay, timeSpeed,
+                                lampPlaced, showWolfPack, animationRuntime.lodSettings.enabled };
+        recorder.start(recordPath, simClock.step, scene);
+    }
+
+    // Late-latched camera: the simulated camera plus mouse look that is not simulated yet
+    CameraLatch cameraLatch;
+    auto latchCamera = [&](float alpha, double inputTime) {
+        Camera latest = camera;
+        float dx, dy;
+        input.pendingMouseMotion(dx, dy);
+        if (mouseLook)
+            latest.ProcessMouseMovement(dx, dy);
+        float aspect = framebufferHeight > 0 ? (float)framebufferWidth / framebufferHeight : 1.0f;
+        glm::mat4 projection = glm::perspective(glm::radians(latest.Zoom), aspect, 0.1f, 100.0f);
+        cameraLatch.store({ latest.GetViewMatrix(alpha), projection, inputTime });
+    };
+
+    // Render thread: owns the GL context from here on and submits frame N while the
+    // main thread simulates frame N+1
+    FramePresenter presenter;
+    presenter.headless = headless;
+    if (headless)
+        presenter.swapMode = SWAP_IMMEDIATE;
+    FramePipeline<FrameSnapshot> pipeline;
+    ImGui_ImplOpenGL3_NewFrame(); // creates the font texture from the final atlas while this thread still owns the context
+    GLuint fontTexture = (GLuint)(intptr_t)io.Fonts->TexID;
+    MemoryTracker::instance().gpuAllocated(MEM_IMGUI, GPU_TEXTURE, fontTexture, (size_t)io.Fonts->TexWidth * io.Fonts->TexHeight * 4);
+    pipeline.start(window, [&](FrameSnapshot &frame) {
+        double renderStart = glfwGetTime();
+        // GL work handed over by jobs
+        jobSystem.drainGLThread();
+        worldRenderer.upload(frame.chunkUploads);
+
+        // Рендеринг: the frame as a render graph, declared every frame, culled and executed
+        if (gpuTimers.beginFrame()) {
+            dynamicResolution.reportGpuTime(gpuTimers.frameMs());
+            benchmark.add(BENCH_GPU, gpuTimers.frameMs());
+        }
+        int renderWidth, renderHeight;
+        dynamicResolution.renderSize(frame.framebufferWidth, frame.framebufferHeight, renderWidth, renderHeight);
+        renderGraph.beginFrame(frame.framebufferWidth, frame.framebufferHeight, renderWidth, renderHeight);
+        RenderResource sceneColor = 0, sceneDepth = 0;
+        Frustum viewFrustum; // from the latched camera
+
+        renderGraph.addPass("Models", [&](RenderPassBuilder &pass) {
+            sceneColor = pass.create("scene color", FORMAT_RGBA8);
+            sceneDepth = pass.create("scene depth", FORMAT_DEPTH24_STENCIL8);
+            pass.write(sceneColor);
+            pass.write(sceneDepth);
+        }, [&](RenderGraph &) {
+            /// HUMAN MODEL
+            Shader &humanShader = humanCharacter < 0 ? modelShader : skinnedModelShader;
+            if (humanCharacter >= 0)
+                bonePalette.upload(frame.humanPalette);
+            humanShader.use();
+            glm::mat4 model = glm::mat4(1.0f); // Identity matrix for the model
+            model = glm::translate(model, glm::vec3(-1.0f, -1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f)); // FIXME: scale factor = ...
+            humanShader.setMat4("model", model);
+            humanModel.Draw(humanShader);
+            // HUMAN MODEL
+
+            /// WOLF MODEL
+            Shader &wolfShader = wolfCharacter < 0 ? modelShader : skinnedModelShader;
+            if (wolfCharacter >= 0)
+                bonePalette.upload(frame.wolfPalette);
+            wolfShader.use();
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, wolfBodyTexture);
+            RenderStats::instance().textureBind();
+            wolfShader.setInt("bodyTexture", 0);
+
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, wolfEyesTexture);
+            RenderStats::instance().textureBind();
+            wolfShader.setInt("eyesTexture", 1);
+
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, wolfFurTexture);
+            RenderStats::instance().textureBind();
+            wolfShader.setInt("furTexture", 2);
+
+            glm::mat4 wmodel = glm::mat4(1.0f); // Identity matrix for the model
+            wmodel = glm::translate(wmodel, glm::vec3(-1.5f, -1.0f, 0.0f));
+            wmodel = glm::scale(wmodel, glm::vec3(1.0f, 1.0f, 1.0f)); // FIXME: scale factor = ...
+            wolfShader.setMat4("model", wmodel);
+            wolfModel.Draw(wolfShader);
+
+            if (frame.showWolfPack) {
+                crowdShader.use();
+                crowdShader.setInt("bodyTexture", 0);
+                crowdShader.setInt("eyesTexture", 1);
+                crowdShader.setInt("furTexture", 2);
+                wolfPack.draw(crowdShader, wolfBaked, frame.time);
+            }
+            // WOLF MODEL
+        });
+
+        renderGraph.addPass("Terrain", [&](RenderPassBuilder &pass) {
+            pass.write(sceneColor);
+            pass.write(sceneDepth);
+        }, [&](RenderGraph &) {
+            chunkShader.use();
+            chunkShader.setFloat("daylight", frame.timeOfDay);
+            worldRenderer.draw(chunkShader, viewFrustum);
+        });
+
+        // Рисование кубов и плоскости в буфер трафарета
+        renderGraph.addPass("Cube stencil", [&](RenderPassBuilder &pass) {
+            pass.write(sceneColor);
+            pass.write(sceneDepth);
+        }, [&](RenderGraph &) {
             glStencilFunc(GL_ALWAYS, 1, 0xFF);
             glStencilMask(0xFF);
             shader.use();
             float pixelSize = 0.01f; // You can adjust this value to change the pixelation effect
             shader.setFloat("pixelSize", pixelSize);
-            shader.setFloat("timeOfDay", timeOfDay); // Set the time of day
-            cube.draw(shader);
-        }
-
-        // Рисование плоскости в буфер трафарета
-        glStencilFunc(GL_ALWAYS, 1, 0xFF);
-        glStencilMask(0xFF);
-        shader.use();
-        float pixelSize = 0.001f; // You can adjust this value to change the pixelation effect
-        shader.setFloat("pixelSize", pixelSize);
-        shader.setFloat("timeOfDay", timeOfDay); // Set the time of day
-
-        // Bind the plane texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, planeTexture);
-        shader.setInt("texture1", 0);
+            shader.setFloat("timeOfDay", frame.timeOfDay); // Set the time of day
+            for (auto& cube : frame.cubes)
+                cube.draw(shader, frame.alpha);
 
-        plane.draw(shader);
+            pixelSize = 0.001f;
+            shader.setFloat("pixelSize", pixelSize);
+            // Bind the plane texture
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, planeTexture);
+            RenderStats::instance().textureBind();
+            shader.setInt("texture1", 0);
+            plane.draw(shader);
+        });
 
         // Рисование обводки только в областях перекрытия
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilMask(0x00);
-        glDisable(GL_DEPTH_TEST);
-        outlineShader.use();
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glLineWidth(20.0f); // Установка толщины линии для обводки
-
-        for (auto& cube : cubes) {
-            cube.updateRotation(ImGui::GetIO().DeltaTime);
-            cube.draw(outlineShader);
-        }
-
-        plane.draw(outlineShader);
+        renderGraph.addPass("Outline", [&](RenderPassBuilder &pass) {
+            pass.write(sceneColor);
+            pass.write(sceneDepth);
+            pass.state().depthTest = false;
+            pass.state().polygonMode = GL_LINE;
+        }, [&](RenderGraph &) {
+            glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+            glStencilMask(0x00);
+            outlineShader.use();
+            glLineWidth(20.0f); // Установка толщины линии для обводки
+            for (auto& cube : frame.cubes)
+                cube.draw(outlineShader, frame.alpha);
+            plane.draw(outlineShader);
+        });
 
         // Рисование основной текстуры
-        glStencilMask(0xFF);
-        glEnable(GL_DEPTH_TEST);
-        shader.use();
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        renderGraph.addPass("Fill", [&](RenderPassBuilder &pass) {
+            pass.write(sceneColor);
+            pass.write(sceneDepth);
+        }, [&](RenderGraph &) {
+            glStencilMask(0xFF);
+            shader.use();
+            for (auto& cube : frame.cubes)
+                cube.draw(shader, frame.alpha);
+            plane.draw(shader);
+        });
+
+        // Upscale to the window, the UI stays at native resolution
+        renderGraph.addPass("Upscale", [&](RenderPassBuilder &pass) {
+            pass.read(sceneColor);
+            pass.write(BACKBUFFER, WRITE_DISCARD);
+            pass.state().depthTest = false;
+            pass.state().stencilTest = false;
+        }, [&](RenderGraph &graph) {
+            dynamicResolution.composite(graph.texture(sceneColor), graph.uvScale(), graph.targetSize());
+        });
+
+        // Rendering ImGui
+        renderGraph.addPass("UI", [&](RenderPassBuilder &pass) {
+            pass.write(BACKBUFFER);
+            pass.sideEffect();
+        }, [&](RenderGraph &) {
+            ImGui_ImplOpenGL3_RenderDrawData(&frame.ui.drawData);
+            RenderStats::instance().uiDrawData(frame.ui.drawData);
+        });
+
+        renderGraph.compile();
+
+        // Latch the newest camera as late as possible, right before the first draw
+        CameraState latched = cameraLatch.load();
+        cameraBuffer.upload(latched);
+        viewFrustum = Frustum(latched.projection * latched.view);
+        renderGraph.execute();
+        RenderGraph::Stats executed = renderGraph.stats();
+        Profiler::instance().counter("Render passes", executed.passes);
+        gpuTimers.endFrame();
+        RenderCounters counted = RenderStats::instance().endFrame();
+        Profiler::instance().counter("Draw calls", (double)counted.draws);
+        Profiler::instance().counter("Uploaded bytes", (double)(counted.bufferUploadBytes + counted.textureUploadBytes));
+        benchmark.addRenderFrame(executed.passes, counted);
+        benchmark.add(BENCH_RENDER_THREAD, (float)((glfwGetTime() - renderStart) * 1000.0));
+
+        // Обмен буферов, paced by the presenter
+        presenter.present(window, latched.inputTime);
+    });
+
+    // Основной цикл: input, simulation and UI for the next frame
+    Profiler::instance().setThreadName("Main");
+    ProfilerPanel profilerPanel;
+    bool showProfiler = false;
+    RenderStatsPanel renderStatsPanel;
+    bool showRenderStats = false;
+    MemoryPanel memoryPanel;
+    bool showMemory = false;
+    double frameStart = glfwGetTime();
+    while (!glfwWindowShouldClose(window)) {
+        Profiler::instance().frameMark();
+        traceCapture.update();
+        if (benchmark.active()) {
+            double now = glfwGetTime();
+            benchmark.add(BENCH_FRAME, (float)((now - frameStart) * 1000.0));
+            frameStart = now;
+            if (benchmark.finished())
+                break;
+        }
+        const RecordedFrame* replayed = nullptr;
+        if (replay.loaded()) {
+            replayed = replay.next();
+            if (!replayed)
+                break; // end of the recording
+        }
+        recordedFrame.clear();
 
-        for (auto& cube : cubes) {
-            cube.draw(shader);
+        // Обработка событий
+        glfwPollEvents();
+        double inputTime = glfwGetTime();
+
+        // Fixed-rate simulation; each tick applies the input events that happened during it.
+        // Benchmarks run on their own clock: one tick per frame, however long frames take.
+        // Replays run on the recorded clock and feed each tick the events it consumed then
+        double simTime = replayed ? replayed->clock : benchmark.active() ? benchmark.clock() : glfwGetTime();
+        bool uiWantsMouse = replayed ? replayed->uiWantsMouse : ImGui::GetIO().WantCaptureMouse;
+        recordedFrame.clock = simTime;
+        recordedFrame.uiWantsMouse = uiWantsMouse;
+        size_t replayedEvent = 0;
+        int ticks = simClock.advance(simTime);
+        for (int tick = 0; tick < ticks; tick++) {
+            PROFILE_ZONE("Simulation tick");
+            float step = (float)simClock.step;
+            for (; replayed && replayedEvent < replayed->events.size() && replayed->events[replayedEvent].time < simClock.tickEnd(tick); replayedEvent++)
+                input.record(replayed->events[replayedEvent]);
+            input.tick(simClock.tickStart(tick), simClock.tickEnd(tick), tickInput);
+            if (recorder.active())
+                recordedFrame.events.insert(recordedFrame.events.end(), tickInput.events.begin(), tickInput.events.end());
+            for (const InputEvent &event : tickInput.events) {
+                if (event.type == INPUT_KEY && event.code == GLFW_KEY_ESCAPE && event.action == GLFW_PRESS)
+                    glfwSetWindowShouldClose(window, true);
+                if (event.type == INPUT_KEY && event.code == GLFW_KEY_F9 && event.action == GLFW_PRESS)
+                    traceCapture.start(traceFrames, tracePath);
+                if (event.type == INPUT_KEY && event.code == GLFW_KEY_F8 && event.action == GLFW_PRESS && !replayed)
+                    cameraPath.append({ camera.Position, camera.Yaw, camera.Pitch }, cameraPathFile);
+                // Mouse look while the left button is held, unless the click went to the UI
+                if (event.type == INPUT_MOUSE_BUTTON && event.code == GLFW_MOUSE_BUTTON_LEFT) {
+                    bool look = event.action == GLFW_PRESS && !uiWantsMouse;
+                    if (look != mouseLook) {
+                        mouseLook = look;
+                        if (!replayed)
+                            input.setMouseCaptured(window, mouseLook, rawMouseMotion);
+                    }
+                }
+                if (event.type == INPUT_MOUSE_MOVE && mouseLook)
+                    camera.ProcessMouseMovement(event.x, event.y);
+                if (event.type == INPUT_SCROLL && !uiWantsMouse)
+                    camera.ProcessMouseScroll(event.y);
+            }
+
+            // WASD or arrow keys, moved by how long they were held within this tick
+            camera.PreviousPosition = camera.Position;
+            camera.ProcessKeyboard(FORWARD, std::max(tickInput.heldSeconds(GLFW_KEY_W), tickInput.heldSeconds(GLFW_KEY_UP)));
+            camera.ProcessKeyboard(BACKWARD, std::max(tickInput.heldSeconds(GLFW_KEY_S), tickInput.heldSeconds(GLFW_KEY_DOWN)));
+            camera.ProcessKeyboard(LEFT, std::max(tickInput.heldSeconds(GLFW_KEY_A), tickInput.heldSeconds(GLFW_KEY_LEFT)));
+            camera.ProcessKeyboard(RIGHT, std::max(tickInput.heldSeconds(GLFW_KEY_D), tickInput.heldSeconds(GLFW_KEY_RIGHT)));
+
+            // Update time of day
+            previousTimeOfDay = timeOfDay;
+            timeOfDay += timeSpeed * step;
+            if (timeOfDay > 1.0f) {
+                timeOfDay = 0.0f;
+                previousTimeOfDay = 0.0f;
+            }
+
+            for (auto& cube : cubes)
+                cube.updateRotation(step);
+
+            if (benchmark.active() && !replayed) {
+                CameraKey key = cameraPath.sample(benchmark.progress());
+                camera.PreviousPosition = camera.Position = key.position;
+                camera.SetOrientation(key.yaw, key.pitch);
+            }
+        }
+        float alpha = simClock.alpha();
+        latchCamera(alpha, inputTime);
+
+        // Pose evaluation for every animated character, spread over the worker threads
+        {
+            PROFILE_ZONE("Animation");
+            MemoryScope memory(MEM_ANIMATION);
+            recordedFrame.animationDelta = replayed ? replayed->animationDelta : benchmark.active() ? (float)benchmark.step : ImGui::GetIO().DeltaTime;
+            animationRuntime.update(recordedFrame.animationDelta, camera.Position, camera.Zoom);
+        }
+        {
+            PROFILE_ZONE("World edits");
+            MemoryScope memory(MEM_WORLD);
+            worldEditor.flush();
         }
 
-        plane.draw(shader);
+        // Poll once more before possibly waiting for the render thread, so the camera it
+        // latches is as fresh as possible; these events are simulated next frame
+        glfwPollEvents();
+        latchCamera(alpha, glfwGetTime());
+
+        // Snapshot for the render thread; blocks only when it is a full frame behind
+        double waitStart = glfwGetTime();
+        FrameSnapshot &frame = pipeline.beginFrame();
+        double waitMs = (glfwGetTime() - waitStart) * 1000.0;
+        frame.alpha = alpha;
+        frame.timeOfDay = glm::mix(previousTimeOfDay, timeOfDay, alpha);
+        frame.time = (float)simTime;
+        frame.framebufferWidth = framebufferWidth;
+        frame.framebufferHeight = framebufferHeight;
+        frame.cubes = cubes;
+        if (humanCharacter >= 0)
+            frame.humanPalette = animationRuntime.characters[humanCharacter].palette;
+        if (wolfCharacter >= 0)
+            frame.wolfPalette = animationRuntime.characters[wolfCharacter].palette;
+        frame.showWolfPack = showWolfPack;
+        {
+            PROFILE_ZONE("Chunk meshing");
+            worldRenderer.update(frame.chunkUploads);
+        }
+        Profiler::instance().counter("Simulation ticks", ticks);
+        Profiler::instance().counter("Chunks remeshed", worldRenderer.remeshedLastFrame);
 
         // Start the ImGui frame
+        PROFILE_ZONE("UI");
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -431,20 +854,127 @@ int main() {
         glm::vec3 cameraPos = camera.Position;
         ImGui::Text("Camera Position: (%.2f, %.2f, %.2f)", cameraPos.x, cameraPos.y, cameraPos.z);
 
-        // Time of day slider
-        ImGui::SliderFloat("Time of Day", &timeOfDay, 0.0f, 1.0f);
+        // Time of day slider; a replay's settings come from the recording
+        uiActions.clear();
+        ImGui::BeginDisabled(replayed != nullptr);
+        float sliderTimeOfDay = timeOfDay;
+        if (ImGui::SliderFloat("Time of Day", &sliderTimeOfDay, 0.0f, 1.0f))
+            uiActions.push_back({ UI_TIME_OF_DAY, sliderTimeOfDay });
+        ImGui::EndDisabled();
+        ImGui::Text("Simulation: %d ticks this frame at %.0f Hz", simClock.ticksLastFrame, 1.0 / simClock.step);
+        if (glfwRawMouseMotionSupported())
+            ImGui::Checkbox("Raw mouse motion", &rawMouseMotion);
+        if (input.droppedEvents > 0)
+            ImGui::Text("Input events dropped: %d", input.droppedEvents);
+
+        // Presentation
+        PresentStats presentStats = presenter.stats();
+        int swapMode = presenter.swapMode;
+        if (ImGui::Combo("Swap", &swapMode, "Immediate\0VSync\0Adaptive VSync\0"))
+            presenter.swapMode = swapMode;
+        int frameCap = presenter.frameCap;
+        if (ImGui::SliderInt("Frame cap", &frameCap, 0, 240, frameCap == 0 ? "off" : "%d FPS"))
+            presenter.frameCap = frameCap;
+        int maxQueued = presenter.maxQueuedFrames;
+        if (ImGui::SliderInt("Max queued frames", &maxQueued, 1, 3))
+            presenter.maxQueuedFrames = maxQueued;
+        ImGui::Text("Frame: %.2f ms (avg %.2f, max %.2f), GPU queue %d", presentStats.frameMs, presentStats.frameMsAvg, presentStats.frameMsMax, presentStats.queuedFrames);
+        ImGui::Text("Input to GPU done: %.2f ms (avg %.2f)", presentStats.latencyMs, presentStats.latencyMsAvg);
+
+        // Dynamic resolution
+        DynamicResolutionStats resolutionStats = dynamicResolution.stats();
+        bool dynamicEnabled = dynamicResolution.enabled;
+        if (ImGui::Checkbox("Dynamic resolution", &dynamicEnabled))
+            dynamicResolution.enabled = dynamicEnabled;
+        float budgetMs = dynamicResolution.budgetMs;
+        if (ImGui::SliderFloat("GPU budget", &budgetMs, 2.0f, 33.0f, "%.1f ms"))
+            dynamicResolution.budgetMs = budgetMs;
+        float sharpness = dynamicResolution.sharpness;
+        if (ImGui::SliderFloat("Upscale sharpness", &sharpness, 0.0f, 1.0f))
+            dynamicResolution.sharpness = sharpness;
+        ImGui::Text("Scene: %dx%d (%.0f%%), GPU %.2f ms (avg %.2f)", resolutionStats.width, resolutionStats.height,
+                    resolutionStats.scale * 100.0f, resolutionStats.gpuMs, resolutionStats.gpuMsAvg);
+        RenderGraph::Stats graphStats = renderGraph.stats();
+        ImGui::Text("Render graph: %d passes (%d culled), %d clears, %d invalidated, %d pooled targets",
+                    graphStats.passes, graphStats.culled, graphStats.clears, graphStats.invalidations, graphStats.pooledTextures);
+
+        ImGui::BeginDisabled(replayed != nullptr);
+        bool lamp = lampPlaced;
+        if (ImGui::Checkbox("Lamp", &lamp))
+            uiActions.push_back({ UI_LAMP, lamp ? 1.0f : 0.0f });
+        if (ImGui::Button("Crater"))
+            uiActions.push_back({ UI_CRATER, 0.0f });
+        ImGui::SameLine();
+        if (ImGui::Button("Wall"))
+            uiActions.push_back({ UI_WALL, 0.0f });
+        ImGui::EndDisabled();
+        ImGui::Text("Light update: %.3f ms, edits: %d", lightEngine.lastUpdateMs, worldEditor.editsLastFrame);
+        ImGui::Text("Chunks remeshed: %d (%d dirty regions)", worldRenderer.remeshedLastFrame, worldRenderer.dirtyRegionsLastFrame);
+        const AnimationFrameStats &animStats = animationRuntime.lastStats;
+        ImGui::Text("Animation: %d characters, %.3f ms", (int)animationRuntime.characters.size(), animationRuntime.lastUpdateMs);
+        ImGui::Text("  evaluated %d, interpolated %d (LOD %d/%d/%d/%d)", animStats.evaluated, animStats.interpolated,
+                    animStats.perLod[0], animStats.perLod[1], animStats.perLod[2], animStats.perLod[3]);
+        ImGui::BeginDisabled(replayed != nullptr);
+        bool animationLod = animationRuntime.lodSettings.enabled;
+        if (ImGui::Checkbox("Animation LOD", &animationLod))
+            uiActions.push_back({ UI_ANIMATION_LOD, animationLod ? 1.0f : 0.0f });
+        bool wolfPackShown = showWolfPack;
+        if (!wolfBaked.empty() && ImGui::Checkbox("Wolf pack (instanced)", &wolfPackShown))
+            uiActions.push_back({ UI_WOLF_PACK, wolfPackShown ? 1.0f : 0.0f });
+        ImGui::EndDisabled();
+        if (replayed)
+            ImGui::Text("Replaying: frame %d / %d", replay.position(), (int)replay.frames.size());
+        else if (recorder.active())
+            ImGui::Text("Recording input: %d frames", recorder.frames());
+        ImGui::Checkbox("Profiler", &showProfiler);
+        ImGui::SameLine();
+        ImGui::Checkbox("Renderer stats", &showRenderStats);
+        ImGui::SameLine();
+        ImGui::Checkbox("Memory", &showMemory);
+        ImGui::SameLine();
+        if (traceCapture.active())
+            ImGui::Text("Capturing trace...");
+        else if (ImGui::Button("Capture trace (F9)"))
+            traceCapture.start(traceFrames, tracePath);
 
         ImGui::End();
 
-        // Rendering ImGui
+        if (replayed)
+            uiActions = replayed->actions;
+        for (const UiAction &action : uiActions)
+            applyUiAction(action);
+        if (recorder.active()) {
+            recordedFrame.actions = uiActions;
+            recorder.write(recordedFrame);
+        }
+
+        if (showProfiler)
+            profilerPanel.draw();
+        if (showRenderStats)
+            renderStatsPanel.draw();
+        if (showMemory)
+            memoryPanel.draw();
+
+        // UI draw data is copied into the snapshot, the render thread draws it next
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        frame.ui.capture(ImGui::GetDrawData());
+        pipeline.publish();
 
-        // Обмен буферов и обработка событий
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (benchmark.active()) {
+            benchmark.add(BENCH_MAIN_THREAD, (float)((glfwGetTime() - frameStart) * 1000.0 - waitMs));
+            benchmark.nextFrame();
+        }
     }
 
+    // Let the render thread finish, then take the context back for cleanup
+    pipeline.shutdown();
+    glfwMakeContextCurrent(window);
+    recorder.stop();
+
+    int exitCode = 0;
+    if (benchmark.active() && !benchmark.writeReport(rendererName, framebufferWidth, framebufferHeight))
+        exitCode = 1;
+
     // Очистка
     for (auto& cube : cubes) {
         glDeleteVertexArrays(1, &cube.VAO);
@@ -464,12 +994,26 @@ int main() {
     glDeleteBuffers(1, &wolfModel.VBO);
     glDeleteBuffers(1, &wolfModel.EBO);
 
+    worldRenderer.destroy();
+    bonePalette.destroy();
+    wolfPack.destroy();
+    wolfBaked.destroy();
+    presenter.destroy();
+    cameraBuffer.destroy();
+    dynamicResolution.destroy();
+    gpuTimers.destroy();
+    renderGraph.destroy();
+    glDeleteFramebuffers(1, &headlessFBO);
+    MemoryTracker::instance().gpuFreed(GPU_RENDERBUFFER, headlessColor);
+    glDeleteRenderbuffers(1, &headlessColor);
+
     // Cleanup ImGui
+    MemoryTracker::instance().gpuFreed(GPU_TEXTURE, fontTexture);
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
     // Завершение GLFW
     glfwTerminate();
-    return 0;
+    return exitCode;
 }